@@ -1,177 +1,136 @@
+// Interactive front end for the Banker's algorithm library.
+// Build: gcc banker's_algo.c banker.c -pthread
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 
-#define MAX_PROCESSES 100
-#define MAX_RESOURCES 100
+#include "banker.h"
 
-// Function to check if the requested resources can be allocated
-bool isSafe(int processes[], int available[], int max[][MAX_RESOURCES],
-            int allocation[][MAX_RESOURCES], int need[][MAX_RESOURCES],
-            int num_processes, int num_resources) {
-    bool finish[MAX_PROCESSES] = {false};
-    int work[MAX_RESOURCES];
-    int safe_sequence[MAX_PROCESSES];
-    int count = 0;
+void printSafeSequence(int safe_sequence[], int num_processes) {
+    printf("\nSystem is in safe state.\nSafe sequence: ");
+    for (int i = 0; i < num_processes; i++) {
+        printf("P%d ", safe_sequence[i]);
+    }
+    printf("\n");
+}
 
-    // Initialize work array with available resources
-    for (int i = 0; i < num_resources; i++) {
-        work[i] = available[i];
+// Function to check if the system is in a safe state
+bool isSafe(BankerState* state) {
+    if (!buildCertificate(state)) {
+        printf("\nSystem is not in safe state\n");
+        return false;
     }
 
-    // Find a process that can be allocated resources
-    while (count < num_processes) {
-        bool found = false;
-
-        for (int p = 0; p < num_processes; p++) {
-            if (!finish[p]) {
-                bool possible = true;
-
-                // Check if all resources for this process can be allocated
-                for (int r = 0; r < num_resources; r++) {
-                    if (need[p][r] > work[r]) {
-                        possible = false;
-                        break;
-                    }
-                }
-
-                // If allocation is possible
-                if (possible) {
-                    // Add allocated resources back to work
-                    for (int r = 0; r < num_resources; r++) {
-                        work[r] += allocation[p][r];
-                    }
-
-                    safe_sequence[count] = p;
-                    finish[p] = true;
-                    count++;
-                    found = true;
-                }
-            }
-        }
+    printSafeSequence(state->cert.sequence, state->num_processes);
+    return true;
+}
 
-        // If no process can be allocated resources, system is not in safe state
-        if (!found) {
-            printf("\nSystem is not in safe state\n");
-            return false;
+// Display current state
+void printState(BankerState* state) {
+    printf("\nCurrent resource allocation:\n");
+    for (int i = 0; i < state->num_processes; i++) {
+        int* allocation = state_row(state->allocation, state, i);
+        printf("Process %d:", i);
+        for (int j = 0; j < state->num_resources; j++) {
+            printf(" %d", allocation[j]);
         }
+        printf("\n");
     }
 
-    printf("\nSystem is in safe state.\nSafe sequence: ");
-    for (int i = 0; i < num_processes; i++) {
-        printf("P%d ", safe_sequence[i]);
+    printf("\nAvailable resources:");
+    for (int i = 0; i < state->num_resources; i++) {
+        printf(" %d", state->available[i]);
     }
     printf("\n");
-
-    return true;
 }
 
 // Function to request resources
-bool requestResources(int process_id, int request[], int processes[], 
-                     int available[], int max[][MAX_RESOURCES],
-                     int allocation[][MAX_RESOURCES], int need[][MAX_RESOURCES],
-                     int num_processes, int num_resources) {
-    // Check if request is valid
-    for (int r = 0; r < num_resources; r++) {
-        if (request[r] > need[process_id][r]) {
+bool requestResources(BankerState* state, int process_id, const int request[]) {
+    switch (banker_request(state, process_id, request)) {
+        case REQUEST_GRANTED:
+            printSafeSequence(state->cert.sequence, state->num_processes);
+            return true;
+        case REQUEST_EXCEEDS_CLAIM:
             printf("\nError: Requested resources exceed maximum claim\n");
             return false;
-        }
-        if (request[r] > available[r]) {
+        case REQUEST_UNAVAILABLE:
             printf("\nError: Resources not available\n");
             return false;
-        }
-    }
-
-    // Try to allocate resources
-    for (int r = 0; r < num_resources; r++) {
-        available[r] -= request[r];
-        allocation[process_id][r] += request[r];
-        need[process_id][r] -= request[r];
-    }
-
-    // Check if system remains in safe state
-    if (isSafe(processes, available, max, allocation, need, 
-               num_processes, num_resources)) {
-        return true;
-    }
-
-    // If not safe, rollback changes
-    for (int r = 0; r < num_resources; r++) {
-        available[r] += request[r];
-        allocation[process_id][r] -= request[r];
-        need[process_id][r] += request[r];
+        case REQUEST_UNSAFE:
+            printf("\nRequest denied: Would lead to unsafe state\n");
+            return false;
+        default:
+            printf("\nError: Invalid request\n");
+            return false;
     }
-
-    printf("\nRequest denied: Would lead to unsafe state\n");
-    return false;
 }
 
 int main() {
     int num_processes, num_resources;
-    
+
     // Get number of processes and resources
     printf("Enter number of processes: ");
     scanf("%d", &num_processes);
     printf("Enter number of resources: ");
     scanf("%d", &num_resources);
 
-    if (num_processes > MAX_PROCESSES || num_resources > MAX_RESOURCES) {
-        printf("Error: Number of processes or resources exceeds maximum limit\n");
+    if (num_processes <= 0 || num_resources <= 0) {
+        printf("Error: Number of processes and resources must be positive\n");
         return 1;
     }
 
-    int processes[MAX_PROCESSES];
-    int available[MAX_RESOURCES];
-    int max[MAX_PROCESSES][MAX_RESOURCES];
-    int allocation[MAX_PROCESSES][MAX_RESOURCES];
-    int need[MAX_PROCESSES][MAX_RESOURCES];
-
-    // Initialize process IDs
-    for (int i = 0; i < num_processes; i++) {
-        processes[i] = i;
-    }
+    BankerState* state = init_banker_state(num_processes, num_resources);
+    int* request = (int*)malloc(num_resources * sizeof(int));
 
     // Get available resources
     printf("\nEnter number of available resources:\n");
     for (int i = 0; i < num_resources; i++) {
         printf("Resource %d: ", i);
-        scanf("%d", &available[i]);
+        scanf("%d", &state->available[i]);
     }
 
     // Get maximum resource claims for each process
     printf("\nEnter maximum resource claims for each process:\n");
     for (int i = 0; i < num_processes; i++) {
+        int* max = state_row(state->max, state, i);
         printf("Process %d:\n", i);
         for (int j = 0; j < num_resources; j++) {
             printf("Resource %d: ", j);
-            scanf("%d", &max[i][j]);
+            scanf("%d", &max[j]);
         }
     }
 
     // Get current resource allocation for each process
     printf("\nEnter current resource allocation for each process:\n");
     for (int i = 0; i < num_processes; i++) {
+        int* max = state_row(state->max, state, i);
+        int* allocation = state_row(state->allocation, state, i);
+        int* need = state_row(state->need, state, i);
         printf("Process %d:\n", i);
         for (int j = 0; j < num_resources; j++) {
             printf("Resource %d: ", j);
-            scanf("%d", &allocation[i][j]);
-            
+            scanf("%d", &allocation[j]);
+
             // Validate allocation doesn't exceed maximum claim
-            if (allocation[i][j] > max[i][j]) {
+            if (allocation[j] > max[j]) {
                 printf("Error: Allocation exceeds maximum claim\n");
+                free(request);
+                free_banker_state(state);
                 return 1;
             }
-            
+
             // Calculate need matrix
-            need[i][j] = max[i][j] - allocation[i][j];
+            need[j] = max[j] - allocation[j];
         }
     }
 
     // Check initial state
     printf("\nChecking if system is in safe state:");
-    if (!isSafe(processes, available, max, allocation, need, 
-                num_processes, num_resources)) {
+    if (!isSafe(state)) {
         printf("Initial state is unsafe. Exiting.\n");
+        free(request);
+        free_banker_state(state);
         return 1;
     }
 
@@ -180,16 +139,16 @@ int main() {
         int choice;
         printf("\nOptions:\n");
         printf("1. Request resources\n");
-        printf("2. Exit\n");
+        printf("2. Release resources\n");
+        printf("3. Exit\n");
         printf("Enter choice: ");
         scanf("%d", &choice);
 
-        if (choice == 2) {
+        if (choice == 3) {
             break;
         }
         else if (choice == 1) {
             int process_id;
-            int request[MAX_RESOURCES];
 
             printf("Enter process ID (0 to %d): ", num_processes - 1);
             scanf("%d", &process_id);
@@ -205,28 +164,38 @@ int main() {
                 scanf("%d", &request[i]);
             }
 
-            if (requestResources(process_id, request, processes, available, 
-                               max, allocation, need, num_processes, num_resources)) {
+            if (requestResources(state, process_id, request)) {
                 printf("Request granted\n");
-                
-                // Display current state
-                printf("\nCurrent resource allocation:\n");
-                for (int i = 0; i < num_processes; i++) {
-                    printf("Process %d:", i);
-                    for (int j = 0; j < num_resources; j++) {
-                        printf(" %d", allocation[i][j]);
-                    }
-                    printf("\n");
-                }
-                
-                printf("\nAvailable resources:");
-                for (int i = 0; i < num_resources; i++) {
-                    printf(" %d", available[i]);
-                }
-                printf("\n");
+                printState(state);
+            }
+        }
+        else if (choice == 2) {
+            int process_id;
+
+            printf("Enter process ID (0 to %d): ", num_processes - 1);
+            scanf("%d", &process_id);
+
+            if (process_id < 0 || process_id >= num_processes) {
+                printf("Invalid process ID\n");
+                continue;
+            }
+
+            printf("Enter resources to release for process %d:\n", process_id);
+            for (int i = 0; i < num_resources; i++) {
+                printf("Resource %d: ", i);
+                scanf("%d", &request[i]);
+            }
+
+            if (banker_release(state, process_id, request)) {
+                printf("Resources released\n");
+                printState(state);
+            } else {
+                printf("\nError: Process does not hold those resources\n");
             }
         }
     }
 
+    free(request);
+    free_banker_state(state);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,1488 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "banker.h"
+
+// Allocate count zeroed, cache-line aligned rows of stride ints
+int* alloc_rows(int count, int stride) {
+    size_t size = (size_t)count * stride * sizeof(int);
+    if (size == 0) {
+        size = CACHE_LINE;
+    }
+    int* rows = (int*)aligned_alloc(CACHE_LINE, size);
+    memset(rows, 0, size);
+    return rows;
+}
+
+int* state_row(int* matrix, const BankerState* state, int process) {
+    return matrix + (size_t)process * state->stride;
+}
+
+void init_safety_scratch(SafetyScratch* scratch, int num_processes, int num_resources, int stride) {
+    scratch->work = alloc_rows(1, stride);
+    scratch->sequence = (int*)malloc((num_processes + 1) * sizeof(int));
+    scratch->cursor = (int*)malloc((num_resources + 1) * sizeof(int));
+    scratch->blocked = (int*)malloc((num_processes + 1) * sizeof(int));
+    scratch->needs = (NeedEntry*)malloc(((size_t)num_resources * num_processes + 1) * sizeof(NeedEntry));
+    scratch->this_pass.items = (int*)malloc((num_processes + 1) * sizeof(int));
+    scratch->next_pass.items = (int*)malloc((num_processes + 1) * sizeof(int));
+}
+
+void free_safety_scratch(SafetyScratch* scratch) {
+    free(scratch->work);
+    free(scratch->sequence);
+    free(scratch->cursor);
+    free(scratch->blocked);
+    free(scratch->needs);
+    free(scratch->this_pass.items);
+    free(scratch->next_pass.items);
+}
+
+// Initialize an empty state for the given number of processes and resources
+BankerState* init_banker_state(int num_processes, int num_resources) {
+    BankerState* state = (BankerState*)malloc(sizeof(BankerState));
+    int stride = (num_resources + INTS_PER_LINE - 1) / INTS_PER_LINE * INTS_PER_LINE;
+
+    state->num_processes = num_processes;
+    state->num_resources = num_resources;
+    state->stride = stride;
+    state->available = alloc_rows(1, stride);
+    state->max = alloc_rows(num_processes, stride);
+    state->allocation = alloc_rows(num_processes, stride);
+    state->need = alloc_rows(num_processes, stride);
+
+    state->cert.valid = false;
+    state->cert.sequence = (int*)malloc((num_processes + 1) * sizeof(int));
+    state->cert.position = (int*)malloc((num_processes + 1) * sizeof(int));
+    state->cert.slack = alloc_rows(1, stride);
+
+    state->slack = alloc_rows(1, stride);
+    state->request = alloc_rows(1, stride);
+    init_safety_scratch(&state->scratch, num_processes, num_resources, stride);
+
+    // Prefer writers so a slow-path request is not starved by fast ones
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&state->lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+
+    state->process_locks = (pthread_mutex_t*)malloc((num_processes + 1) * sizeof(pthread_mutex_t));
+    for (int p = 0; p < num_processes; p++) {
+        pthread_mutex_init(&state->process_locks[p], NULL);
+    }
+
+    pthread_mutex_init(&state->wait_lock, NULL);
+    state->waiting_head = NULL;
+    state->waiting_tail = NULL;
+    state->num_waiting = 0;
+    state->arrivals = 0;
+    state->release_epoch = 0;
+    state->wake_policy = WAKE_FIFO;
+
+    pthread_mutex_init(&state->graph_lock, NULL);
+    state->outstanding = alloc_rows(num_processes, stride);
+    state->waiting = (bool*)calloc(num_processes + 1, sizeof(bool));
+    state->num_blocked = 0;
+    state->single_instance = (bool*)calloc(num_resources + 1, sizeof(bool));
+    init_wait_graph(&state->graph, num_processes);
+
+    return state;
+}
+
+// Free the state memory
+void free_banker_state(BankerState* state) {
+    free(state->available);
+    free(state->max);
+    free(state->allocation);
+    free(state->need);
+    free(state->cert.sequence);
+    free(state->cert.position);
+    free(state->cert.slack);
+    free(state->slack);
+    free(state->request);
+    free_safety_scratch(&state->scratch);
+
+    for (int p = 0; p < state->num_processes; p++) {
+        pthread_mutex_destroy(&state->process_locks[p]);
+    }
+    free(state->process_locks);
+    pthread_mutex_destroy(&state->wait_lock);
+    pthread_mutex_destroy(&state->graph_lock);
+    free(state->outstanding);
+    free(state->waiting);
+    free(state->single_instance);
+    free_wait_graph(&state->graph);
+    pthread_rwlock_destroy(&state->lock);
+    free(state);
+}
+
+// Vector kernels over padded rows. AVX2 is used when compiled with -mavx2
+// (or -march=native), SSE2 otherwise on x86-64, and plain C elsewhere.
+
+// Returns true if row[r] <= work[r] for every resource
+bool row_fits(const int* row, const int* work, int stride) {
+#if defined(__AVX2__)
+    for (int r = 0; r < stride; r += 8) {
+        __m256i a = _mm256_load_si256((const __m256i*)(row + r));
+        __m256i b = _mm256_load_si256((const __m256i*)(work + r));
+        __m256i over = _mm256_cmpgt_epi32(a, b);
+        if (!_mm256_testz_si256(over, over)) {
+            return false;
+        }
+    }
+#elif defined(__SSE2__)
+    for (int r = 0; r < stride; r += 4) {
+        __m128i a = _mm_load_si128((const __m128i*)(row + r));
+        __m128i b = _mm_load_si128((const __m128i*)(work + r));
+        if (_mm_movemask_epi8(_mm_cmpgt_epi32(a, b)) != 0) {
+            return false;
+        }
+    }
+#else
+    for (int r = 0; r < stride; r++) {
+        if (row[r] > work[r]) {
+            return false;
+        }
+    }
+#endif
+    return true;
+}
+
+// dst[r] += src[r]
+void row_add(int* dst, const int* src, int stride) {
+#if defined(__AVX2__)
+    for (int r = 0; r < stride; r += 8) {
+        __m256i a = _mm256_load_si256((const __m256i*)(dst + r));
+        __m256i b = _mm256_load_si256((const __m256i*)(src + r));
+        _mm256_store_si256((__m256i*)(dst + r), _mm256_add_epi32(a, b));
+    }
+#elif defined(__SSE2__)
+    for (int r = 0; r < stride; r += 4) {
+        __m128i a = _mm_load_si128((const __m128i*)(dst + r));
+        __m128i b = _mm_load_si128((const __m128i*)(src + r));
+        _mm_store_si128((__m128i*)(dst + r), _mm_add_epi32(a, b));
+    }
+#else
+    for (int r = 0; r < stride; r++) {
+        dst[r] += src[r];
+    }
+#endif
+}
+
+// dst[r] -= src[r]
+void row_sub(int* dst, const int* src, int stride) {
+#if defined(__AVX2__)
+    for (int r = 0; r < stride; r += 8) {
+        __m256i a = _mm256_load_si256((const __m256i*)(dst + r));
+        __m256i b = _mm256_load_si256((const __m256i*)(src + r));
+        _mm256_store_si256((__m256i*)(dst + r), _mm256_sub_epi32(a, b));
+    }
+#elif defined(__SSE2__)
+    for (int r = 0; r < stride; r += 4) {
+        __m128i a = _mm_load_si128((const __m128i*)(dst + r));
+        __m128i b = _mm_load_si128((const __m128i*)(src + r));
+        _mm_store_si128((__m128i*)(dst + r), _mm_sub_epi32(a, b));
+    }
+#else
+    for (int r = 0; r < stride; r++) {
+        dst[r] -= src[r];
+    }
+#endif
+}
+
+// slack[r] = min(slack[r], work[r] - need[r])
+void row_min_slack(int* slack, const int* work, const int* need, int stride) {
+#if defined(__AVX2__)
+    for (int r = 0; r < stride; r += 8) {
+        __m256i s = _mm256_load_si256((const __m256i*)(slack + r));
+        __m256i w = _mm256_load_si256((const __m256i*)(work + r));
+        __m256i n = _mm256_load_si256((const __m256i*)(need + r));
+        _mm256_store_si256((__m256i*)(slack + r), _mm256_min_epi32(s, _mm256_sub_epi32(w, n)));
+    }
+#elif defined(__SSE2__)
+    for (int r = 0; r < stride; r += 4) {
+        __m128i s = _mm_load_si128((const __m128i*)(slack + r));
+        __m128i w = _mm_load_si128((const __m128i*)(work + r));
+        __m128i n = _mm_load_si128((const __m128i*)(need + r));
+        __m128i d = _mm_sub_epi32(w, n);
+        __m128i take = _mm_cmpgt_epi32(s, d);
+        _mm_store_si128((__m128i*)(slack + r),
+                        _mm_or_si128(_mm_and_si128(take, d), _mm_andnot_si128(take, s)));
+    }
+#else
+    for (int r = 0; r < stride; r++) {
+        if (work[r] - need[r] < slack[r]) {
+            slack[r] = work[r] - need[r];
+        }
+    }
+#endif
+}
+
+int compare_need_entries(const void* a, const void* b) {
+    const NeedEntry* x = (const NeedEntry*)a;
+    const NeedEntry* y = (const NeedEntry*)b;
+    if (x->amount != y->amount) {
+        return (x->amount > y->amount) - (x->amount < y->amount);
+    }
+    return (x->process > y->process) - (x->process < y->process);
+}
+
+void heap_push(ProcessHeap* heap, int process) {
+    int i = heap->size++;
+    while (i > 0 && heap->items[(i - 1) / 2] > process) {
+        heap->items[i] = heap->items[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap->items[i] = process;
+}
+
+int heap_pop(ProcessHeap* heap) {
+    int top = heap->items[0];
+    int last = heap->items[--heap->size];
+    int i = 0;
+
+    while (2 * i + 1 < heap->size) {
+        int child = 2 * i + 1;
+        if (child + 1 < heap->size && heap->items[child + 1] < heap->items[child]) {
+            child++;
+        }
+        if (last <= heap->items[child]) {
+            break;
+        }
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    heap->items[i] = last;
+    return top;
+}
+
+// Event-driven safety check. Every resource keeps the outstanding needs
+// sorted by amount, and each process counts the resources still blocking
+// it. When work[r] grows, only the needs on r that just became satisfiable
+// are visited, so a process is woken exactly when its last blocking
+// resource clears. Cost is O(n*m log n) instead of O(n^2*m).
+//
+// Ready processes are picked in the same order as the original pass-by-pass
+// scan: the lowest ready ID after the last finished process, otherwise the
+// lowest ready ID on the next pass. The safe sequence is therefore
+// identical to the one the full scan produces.
+//
+// demand is the matrix each process must be able to get before it can
+// finish: need for avoidance, outstanding requests for detection. If delta
+// is not NULL the run is done as if delta (a padded row) had been granted
+// to delta_process, without touching the state. That lets several threads
+// check different candidate grants at once, each with its own scratch,
+// while the state itself stays read-only.
+//
+// Returns how many processes could finish; they are listed in sequence.
+// Afterwards scratch->blocked[p] is 0 exactly for those processes.
+int reduceProcesses(const BankerState* state, SafetyScratch* scratch, const int* demand,
+                    int delta_process, const int delta[], int sequence[]) {
+    int num_processes = state->num_processes;
+    int num_resources = state->num_resources;
+    int* work = scratch->work;
+    int* cursor = scratch->cursor;
+    int* blocked = scratch->blocked;
+    ProcessHeap* this_pass = &scratch->this_pass;
+    ProcessHeap* next_pass = &scratch->next_pass;
+    int count = 0;
+
+    memcpy(work, state->available, state->stride * sizeof(int));
+    this_pass->size = 0;
+    next_pass->size = 0;
+
+    if (delta == NULL) {
+        delta_process = -1;
+    } else {
+        row_sub(work, delta, state->stride);
+    }
+
+    for (int p = 0; p < num_processes; p++) {
+        blocked[p] = num_resources;
+    }
+
+    // Sort each resource's needs and clear the ones work already covers
+    for (int r = 0; r < num_resources; r++) {
+        NeedEntry* list = scratch->needs + (size_t)r * num_processes;
+
+        for (int p = 0; p < num_processes; p++) {
+            list[p].amount = demand[(size_t)p * state->stride + r];
+            list[p].process = p;
+        }
+        if (delta_process >= 0) {
+            list[delta_process].amount -= delta[r];
+        }
+        qsort(list, num_processes, sizeof(NeedEntry), compare_need_entries);
+
+        cursor[r] = 0;
+        while (cursor[r] < num_processes && list[cursor[r]].amount <= work[r]) {
+            blocked[list[cursor[r]].process]--;
+            cursor[r]++;
+        }
+    }
+
+    for (int p = 0; p < num_processes; p++) {
+        if (blocked[p] == 0) {
+            heap_push(this_pass, p);
+        }
+    }
+
+    while (count < num_processes) {
+        // Nothing left in this pass, start the next one from P0
+        if (this_pass->size == 0) {
+            ProcessHeap* swap = this_pass;
+            this_pass = next_pass;
+            next_pass = swap;
+        }
+
+        // No process can finish, system is not in safe state
+        if (this_pass->size == 0) {
+            break;
+        }
+
+        int p = heap_pop(this_pass);
+        const int* allocated = state_row(state->allocation, state, p);
+        sequence[count++] = p;
+
+        // Release its allocation and wake processes unblocked by it
+        row_add(work, allocated, state->stride);
+        if (p == delta_process) {
+            row_add(work, delta, state->stride);
+        }
+        for (int r = 0; r < num_resources; r++) {
+            if (allocated[r] == 0 && (p != delta_process || delta[r] == 0)) {
+                continue;
+            }
+
+            NeedEntry* list = scratch->needs + (size_t)r * num_processes;
+            while (cursor[r] < num_processes && list[cursor[r]].amount <= work[r]) {
+                int q = list[cursor[r]].process;
+                if (--blocked[q] == 0) {
+                    heap_push(q > p ? this_pass : next_pass, q);
+                }
+                cursor[r]++;
+            }
+        }
+    }
+
+    return count;
+}
+
+bool findSafeSequenceWith(const BankerState* state, SafetyScratch* scratch,
+                          int delta_process, const int delta[], int safe_sequence[]) {
+    return reduceProcesses(state, scratch, state->need, delta_process, delta,
+                           safe_sequence) == state->num_processes;
+}
+
+bool findSafeSequence(BankerState* state, int safe_sequence[]) {
+    return findSafeSequenceWith(state, &state->scratch, -1, NULL, safe_sequence);
+}
+
+// Run a full safety check. On success its safe sequence becomes the
+// certificate; on failure the certificate is left as it was.
+bool findCertificate(BankerState* state) {
+    SafetyCertificate* cert = &state->cert;
+    int* work = state->scratch.work;
+
+    if (!findSafeSequence(state, state->scratch.sequence)) {
+        return false;
+    }
+
+    int* swap = cert->sequence;
+    cert->sequence = state->scratch.sequence;
+    state->scratch.sequence = swap;
+    cert->valid = true;
+
+    memcpy(work, state->available, state->stride * sizeof(int));
+    memcpy(cert->slack, state->available, state->stride * sizeof(int));
+
+    // Record the tightest margin seen anywhere along the sequence
+    for (int k = 0; k < state->num_processes; k++) {
+        int p = cert->sequence[k];
+        cert->position[p] = k;
+        row_min_slack(cert->slack, work, state_row(state->need, state, p), state->stride);
+        row_add(work, state_row(state->allocation, state, p), state->stride);
+    }
+
+    return true;
+}
+
+// Run a full safety check and keep its safe sequence as the certificate
+bool buildCertificate(BankerState* state) {
+    if (!findCertificate(state)) {
+        state->cert.valid = false;
+        return false;
+    }
+    return true;
+}
+
+// Check whether the certificate still holds after request[] was tentatively
+// granted to process_id. Granting lowers work by request[] only for the
+// processes that run before process_id in the sequence; everything from
+// process_id onwards sees exactly the same work as before. So:
+//   - if request[] fits in the recorded slack, the sequence is still safe
+//     and the check is O(m);
+//   - otherwise only the prefix before process_id is re-checked.
+// Releases never raise the recorded slack, so once the prefix passes the
+// rest of the sequence is walked too (without checks) to make the slack
+// exact again and keep later requests on the O(m) path.
+bool checkCertificate(BankerState* state, int process_id, const int request[]) {
+    SafetyCertificate* cert = &state->cert;
+    int stride = state->stride;
+
+    if (!cert->valid) {
+        return false;
+    }
+
+    if (row_fits(request, cert->slack, stride)) {
+        row_sub(cert->slack, request, stride);
+        return true;
+    }
+
+    int* work = state->scratch.work;
+    int* slack = state->slack;
+
+    memcpy(work, state->available, stride * sizeof(int));
+    memcpy(slack, state->available, stride * sizeof(int));
+
+    // Re-check the affected prefix of the sequence
+    for (int k = 0; k < state->num_processes; k++) {
+        const int* needed = state_row(state->need, state, cert->sequence[k]);
+        if (k < cert->position[process_id] && !row_fits(needed, work, stride)) {
+            return false;
+        }
+        row_min_slack(slack, work, needed, stride);
+        row_add(work, state_row(state->allocation, state, cert->sequence[k]), stride);
+    }
+
+    memcpy(cert->slack, slack, stride * sizeof(int));
+    return true;
+}
+
+// Re-validate the certificate after a tentative grant, running a full
+// safety check only when checkCertificate cannot vouch for the sequence.
+// If that fails as well the caller rolls the request back, and the old
+// certificate, which is kept, is valid again.
+bool revalidateCertificate(BankerState* state, int process_id, const int request[]) {
+    if (!state->cert.valid) {
+        return buildCertificate(state);
+    }
+
+    // Sequence no longer works, look for a different one
+    return checkCertificate(state, process_id, request) || findCertificate(state);
+}
+
+// Grant or deny a request while owning the state exclusively. This is the
+// original tentative-allocate / check / rollback sequence.
+RequestStatus requestExclusive(BankerState* state, int process_id, const int request[]) {
+    int stride = state->stride;
+    int* requested = state->request;
+    int* allocated = state_row(state->allocation, state, process_id);
+    int* needed = state_row(state->need, state, process_id);
+
+    // Copy into the padded scratch row so the kernels can use it
+    memcpy(requested, request, state->num_resources * sizeof(int));
+
+    // Check if request is valid
+    if (!row_fits(requested, needed, stride) ||
+        !row_fits(requested, state->available, stride)) {
+        for (int r = 0; r < state->num_resources; r++) {
+            if (request[r] > needed[r]) {
+                return REQUEST_EXCEEDS_CLAIM;
+            }
+            if (request[r] > state->available[r]) {
+                return REQUEST_UNAVAILABLE;
+            }
+        }
+    }
+
+    // Try to allocate resources
+    row_sub(state->available, requested, stride);
+    row_add(allocated, requested, stride);
+    row_sub(needed, requested, stride);
+
+    // Check if system remains in safe state
+    if (revalidateCertificate(state, process_id, requested)) {
+        return REQUEST_GRANTED;
+    }
+
+    // If not safe, rollback changes
+    row_add(state->available, requested, stride);
+    row_sub(allocated, requested, stride);
+    row_add(needed, requested, stride);
+
+    return REQUEST_UNSAFE;
+}
+
+// Atomically take amount from *counter if at least that much is left
+bool try_take(int* counter, int amount) {
+    int current = __atomic_load_n(counter, __ATOMIC_RELAXED);
+    while (current >= amount) {
+        if (__atomic_compare_exchange_n(counter, &current, current - amount, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Optimistic grant. A request that fits both the available vector and the
+// certificate slack cannot make the system unsafe (see
+// revalidateCertificate), so it is granted with per-resource atomics under
+// the shared lock. Anything else falls back to requestExclusive.
+RequestStatus banker_request(BankerState* state, int process_id, const int request[]) {
+    int num_resources = state->num_resources;
+    RequestStatus status = REQUEST_GRANTED;
+    bool fast = true;
+    int taken = 0;
+
+    if (process_id < 0 || process_id >= state->num_processes) {
+        return REQUEST_INVALID;
+    }
+    for (int r = 0; r < num_resources; r++) {
+        if (request[r] < 0) {
+            return REQUEST_INVALID;
+        }
+    }
+
+    pthread_rwlock_rdlock(&state->lock);
+    pthread_mutex_lock(&state->process_locks[process_id]);
+
+    int* allocated = state_row(state->allocation, state, process_id);
+    int* needed = state_row(state->need, state, process_id);
+
+    if (!state->cert.valid) {
+        fast = false;
+    }
+
+    for (int r = 0; r < num_resources && fast; r++) {
+        if (request[r] > needed[r]) {
+            status = REQUEST_EXCEEDS_CLAIM;
+            break;
+        }
+        if (request[r] > __atomic_load_n(&state->available[r], __ATOMIC_RELAXED)) {
+            fast = false;
+        }
+    }
+
+    // Reserve resource by resource, undoing on the first shortfall
+    for (; taken < num_resources && fast && status == REQUEST_GRANTED; taken++) {
+        if (request[taken] == 0) {
+            continue;
+        }
+        if (!try_take(&state->available[taken], request[taken])) {
+            fast = false;
+            break;
+        }
+        if (!try_take(&state->cert.slack[taken], request[taken])) {
+            __atomic_add_fetch(&state->available[taken], request[taken], __ATOMIC_RELEASE);
+            fast = false;
+            break;
+        }
+    }
+
+    if (fast && status == REQUEST_GRANTED) {
+        for (int r = 0; r < num_resources; r++) {
+            allocated[r] += request[r];
+            needed[r] -= request[r];
+        }
+    } else {
+        for (int r = 0; r < taken; r++) {
+            __atomic_add_fetch(&state->available[r], request[r], __ATOMIC_RELEASE);
+            __atomic_add_fetch(&state->cert.slack[r], request[r], __ATOMIC_RELEASE);
+        }
+    }
+
+    pthread_mutex_unlock(&state->process_locks[process_id]);
+    pthread_rwlock_unlock(&state->lock);
+
+    if (fast || status != REQUEST_GRANTED) {
+        return status;
+    }
+
+    // Slow path: decide with the whole state to ourselves
+    pthread_rwlock_wrlock(&state->lock);
+    status = requestExclusive(state, process_id, request);
+    pthread_rwlock_unlock(&state->lock);
+    return status;
+}
+
+// Return resources held by a process. A release never invalidates the
+// certificate: every process up to and including the releasing one sees
+// extra work, and its own need grows by the same amount.
+bool banker_release(BankerState* state, int process_id, const int release[]) {
+    int num_resources = state->num_resources;
+
+    if (process_id < 0 || process_id >= state->num_processes) {
+        return false;
+    }
+
+    pthread_rwlock_rdlock(&state->lock);
+    pthread_mutex_lock(&state->process_locks[process_id]);
+
+    int* allocated = state_row(state->allocation, state, process_id);
+    int* needed = state_row(state->need, state, process_id);
+    bool valid = true;
+
+    for (int r = 0; r < num_resources; r++) {
+        if (release[r] < 0 || release[r] > allocated[r]) {
+            valid = false;
+            break;
+        }
+    }
+
+    if (valid) {
+        for (int r = 0; r < num_resources; r++) {
+            allocated[r] -= release[r];
+            needed[r] += release[r];
+            __atomic_add_fetch(&state->available[r], release[r], __ATOMIC_RELEASE);
+        }
+
+        // Processes waiting on a single-instance resource no longer wait
+        // for this process once it gives that resource up
+        if (state->num_blocked > 0) {
+            pthread_mutex_lock(&state->graph_lock);
+            for (int r = 0; r < num_resources; r++) {
+                if (!state->single_instance[r] || release[r] == 0) {
+                    continue;
+                }
+                for (int w = 0; w < state->num_processes; w++) {
+                    if (state->waiting[w] && state_row(state->outstanding, state, w)[r] > 0) {
+                        wait_graph_remove_edge(&state->graph, w, process_id);
+                    }
+                }
+            }
+            pthread_mutex_unlock(&state->graph_lock);
+        }
+    }
+
+    pthread_mutex_unlock(&state->process_locks[process_id]);
+    pthread_rwlock_unlock(&state->lock);
+
+    if (!valid) {
+        return false;
+    }
+
+    // Let parked requests try again with the released resources
+    __atomic_add_fetch(&state->release_epoch, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&state->num_waiting, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&state->wait_lock);
+        grantWaiters(state);
+        pthread_mutex_unlock(&state->wait_lock);
+    }
+
+    return true;
+}
+
+int compare_pending(const void* a, const void* b) {
+    const PendingRequest* x = *(const PendingRequest* const*)a;
+    const PendingRequest* y = *(const PendingRequest* const*)b;
+    if (x->key != y->key) {
+        return (x->key > y->key) - (x->key < y->key);
+    }
+    return (x->arrival > y->arrival) - (x->arrival < y->arrival);
+}
+
+// Retry parked requests in the order the wake policy picks, waking every
+// one that is granted or turns out to be invalid. A request that cannot go
+// yet is skipped rather than blocking the ones behind it: the process that
+// can finish first may well be parked behind one that is unsafe right now,
+// and stopping there would deadlock. Called with wait_lock held.
+void grantWaiters(BankerState* state) {
+    int count = state->num_waiting;
+    if (count == 0) {
+        return;
+    }
+
+    PendingRequest** order = (PendingRequest**)malloc(count * sizeof(PendingRequest*));
+    int n = 0;
+    for (PendingRequest* w = state->waiting_head; w != NULL; w = w->next) {
+        order[n++] = w;
+    }
+
+    if (state->wake_policy != WAKE_FIFO) {
+        int* left = (int*)malloc(state->num_resources * sizeof(int));
+        banker_query_available(state, left);
+
+        for (int i = 0; i < n; i++) {
+            const int* request = order[i]->request;
+            double key = 0;
+
+            for (int r = 0; r < state->num_resources; r++) {
+                if (state->wake_policy == WAKE_SMALLEST_FIRST) {
+                    key += request[r];
+                } else {
+                    // Dominant share: the largest fraction of any one
+                    // resource that this request would take
+                    double share = (double)request[r] / (left[r] + 1);
+                    if (share > key) {
+                        key = share;
+                    }
+                }
+            }
+            order[i]->key = key;
+        }
+        free(left);
+        qsort(order, n, sizeof(PendingRequest*), compare_pending);
+    }
+
+    for (int i = 0; i < n; i++) {
+        RequestStatus status = banker_request(state, order[i]->process_id, order[i]->request);
+
+        if (status == REQUEST_UNAVAILABLE || status == REQUEST_UNSAFE) {
+            continue;
+        }
+
+        order[i]->done = true;
+        order[i]->status = status;
+        pthread_cond_signal(&order[i]->wakeup);
+    }
+    free(order);
+
+    // Unlink everything that was woken
+    PendingRequest** link = &state->waiting_head;
+    state->waiting_tail = NULL;
+    while (*link != NULL) {
+        if ((*link)->done) {
+            *link = (*link)->next;
+            __atomic_sub_fetch(&state->num_waiting, 1, __ATOMIC_SEQ_CST);
+        } else {
+            state->waiting_tail = *link;
+            link = &(*link)->next;
+        }
+    }
+}
+
+RequestStatus banker_request_wait(BankerState* state, int process_id, const int request[]) {
+    unsigned long epoch = __atomic_load_n(&state->release_epoch, __ATOMIC_SEQ_CST);
+
+    // Under FIFO a new request must not overtake ones already parked
+    bool queue_first = __atomic_load_n(&state->wake_policy, __ATOMIC_RELAXED) == WAKE_FIFO &&
+                       __atomic_load_n(&state->num_waiting, __ATOMIC_SEQ_CST) > 0;
+
+    if (!queue_first) {
+        RequestStatus status = banker_request(state, process_id, request);
+        if (status != REQUEST_UNAVAILABLE && status != REQUEST_UNSAFE) {
+            return status;
+        }
+    }
+
+    PendingRequest waiter;
+    waiter.process_id = process_id;
+    waiter.request = request;
+    waiter.key = 0;
+    waiter.done = false;
+    waiter.status = REQUEST_UNSAFE;
+    waiter.next = NULL;
+    pthread_cond_init(&waiter.wakeup, NULL);
+
+    pthread_mutex_lock(&state->wait_lock);
+    waiter.arrival = state->arrivals++;
+    if (state->waiting_tail == NULL) {
+        state->waiting_head = &waiter;
+    } else {
+        state->waiting_tail->next = &waiter;
+    }
+    state->waiting_tail = &waiter;
+    __atomic_add_fetch(&state->num_waiting, 1, __ATOMIC_SEQ_CST);
+
+    // A release may have slipped in between the attempt and parking
+    if (queue_first || __atomic_load_n(&state->release_epoch, __ATOMIC_SEQ_CST) != epoch) {
+        grantWaiters(state);
+    }
+
+    while (!waiter.done) {
+        pthread_cond_wait(&waiter.wakeup, &state->wait_lock);
+    }
+    pthread_mutex_unlock(&state->wait_lock);
+
+    pthread_cond_destroy(&waiter.wakeup);
+    return (RequestStatus)waiter.status;
+}
+
+void banker_set_wake_policy(BankerState* state, WakePolicy policy) {
+    pthread_mutex_lock(&state->wait_lock);
+    __atomic_store_n(&state->wake_policy, policy, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&state->wait_lock);
+}
+
+// Copy the current allocation and need of one process
+void banker_query(BankerState* state, int process_id, int allocation[], int need[]) {
+    pthread_rwlock_rdlock(&state->lock);
+    pthread_mutex_lock(&state->process_locks[process_id]);
+
+    memcpy(allocation, state_row(state->allocation, state, process_id),
+           state->num_resources * sizeof(int));
+    memcpy(need, state_row(state->need, state, process_id),
+           state->num_resources * sizeof(int));
+
+    pthread_mutex_unlock(&state->process_locks[process_id]);
+    pthread_rwlock_unlock(&state->lock);
+}
+
+// Copy the available vector. Each entry is read atomically, but with
+// requests in flight the vector as a whole is not a single snapshot.
+void banker_query_available(BankerState* state, int available[]) {
+    pthread_rwlock_rdlock(&state->lock);
+    for (int r = 0; r < state->num_resources; r++) {
+        available[r] = __atomic_load_n(&state->available[r], __ATOMIC_ACQUIRE);
+    }
+    pthread_rwlock_unlock(&state->lock);
+}
+
+// Run a full safety check on a consistent snapshot. safe_sequence may be
+// NULL; otherwise it receives the sequence when the state is safe.
+bool banker_is_safe(BankerState* state, int safe_sequence[]) {
+    pthread_rwlock_wrlock(&state->lock);
+    bool safe = buildCertificate(state);
+    if (safe && safe_sequence != NULL) {
+        memcpy(safe_sequence, state->cert.sequence, state->num_processes * sizeof(int));
+    }
+    pthread_rwlock_unlock(&state->lock);
+    return safe;
+}
+
+BankerState* banker_init(int num_processes, int num_resources, const int available[],
+                         const int max[], const int allocation[]) {
+    if (num_processes <= 0 || num_resources <= 0) {
+        return NULL;
+    }
+
+    BankerState* state = init_banker_state(num_processes, num_resources);
+    memcpy(state->available, available, num_resources * sizeof(int));
+
+    for (int p = 0; p < num_processes; p++) {
+        const int* max_row = max + (size_t)p * num_resources;
+        const int* allocation_row = allocation + (size_t)p * num_resources;
+
+        for (int r = 0; r < num_resources; r++) {
+            if (allocation_row[r] > max_row[r]) {
+                free_banker_state(state);
+                return NULL;
+            }
+            state_row(state->max, state, p)[r] = max_row[r];
+            state_row(state->allocation, state, p)[r] = allocation_row[r];
+            state_row(state->need, state, p)[r] = max_row[r] - allocation_row[r];
+        }
+    }
+
+    if (!buildCertificate(state)) {
+        free_banker_state(state);
+        return NULL;
+    }
+
+    classify_resources(state);
+    return state;
+}
+
+void banker_destroy(BankerState* state) {
+    free_banker_state(state);
+}
+
+// Candidate of a batch, ordered by the share of available it would take
+typedef struct {
+    int index;
+    double key;
+} BatchCandidate;
+
+// One worker of a parallel batch round. Workers pull candidates from a
+// shared index and run a full safety check for each against the current,
+// read-only state.
+typedef struct {
+    const BankerState* state;
+    SafetyScratch scratch;
+    const BatchRequest* requests;
+    const int* padded;
+    const int* hard;
+    int hard_count;
+    int* next;
+    bool* safe;
+} BatchWorker;
+
+int compare_batch_candidates(const void* a, const void* b) {
+    const BatchCandidate* x = (const BatchCandidate*)a;
+    const BatchCandidate* y = (const BatchCandidate*)b;
+    if (x->key != y->key) {
+        return (x->key > y->key) - (x->key < y->key);
+    }
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+// Need and available only shrink during a batch, so a request that does
+// not fit now never will. Sets *status to the reason when it does not fit.
+bool batchFits(BankerState* state, int process_id, const int requested[], RequestStatus* status) {
+    const int* needed = state_row(state->need, state, process_id);
+
+    if (row_fits(requested, needed, state->stride) &&
+        row_fits(requested, state->available, state->stride)) {
+        return true;
+    }
+
+    for (int r = 0; r < state->num_resources; r++) {
+        if (requested[r] > needed[r]) {
+            *status = REQUEST_EXCEEDS_CLAIM;
+            return false;
+        }
+        if (requested[r] > state->available[r]) {
+            *status = REQUEST_UNAVAILABLE;
+            return false;
+        }
+    }
+    return false;
+}
+
+void* batch_worker(void* arg) {
+    BatchWorker* worker = (BatchWorker*)arg;
+    const BankerState* state = worker->state;
+    int j;
+
+    while ((j = __atomic_fetch_add(worker->next, 1, __ATOMIC_RELAXED)) < worker->hard_count) {
+        int i = worker->hard[j];
+        worker->safe[j] = findSafeSequenceWith(state, &worker->scratch,
+                                               worker->requests[i].process_id,
+                                               worker->padded + (size_t)i * state->stride,
+                                               worker->scratch.sequence);
+    }
+    return NULL;
+}
+
+// Admit a batch of requests together. Candidates are tried smallest share
+// first. Each is first checked against the certificate, which costs O(m)
+// for most small requests. Candidates the certificate cannot vouch for get
+// a full safety check each, spread across worker threads. The first safe
+// one is granted and the certificate rebuilt, and the rest go round again.
+//
+// Taking back a grant never makes a safe state unsafe, so a candidate that
+// is unsafe on top of the current grants stays unsafe as more are added
+// and is denied for good. The granted set is therefore maximal: no denied
+// request could be added to it.
+void banker_request_batch(BankerState* state, int count, const BatchRequest requests[],
+                          RequestStatus results[]) {
+    int num_resources = state->num_resources;
+    int stride = state->stride;
+    int* padded = alloc_rows(count, stride);
+    BatchCandidate* candidates = (BatchCandidate*)malloc((count + 1) * sizeof(BatchCandidate));
+    int* pending = (int*)malloc((count + 1) * sizeof(int));
+    int* hard = (int*)malloc((count + 1) * sizeof(int));
+    bool* safe = (bool*)malloc((count + 1) * sizeof(bool));
+    int num_pending = 0;
+
+    pthread_rwlock_wrlock(&state->lock);
+
+    for (int i = 0; i < count; i++) {
+        int process_id = requests[i].process_id;
+        bool valid = process_id >= 0 && process_id < state->num_processes;
+        double key = 0;
+
+        for (int r = 0; r < num_resources && valid; r++) {
+            int amount = requests[i].request[r];
+            double share = (double)amount / (state->available[r] + 1);
+            if (amount < 0) {
+                valid = false;
+            }
+            if (share > key) {
+                key = share;
+            }
+            padded[(size_t)i * stride + r] = amount;
+        }
+
+        if (!valid) {
+            results[i] = REQUEST_INVALID;
+            continue;
+        }
+        candidates[num_pending].index = i;
+        candidates[num_pending].key = key;
+        num_pending++;
+    }
+
+    qsort(candidates, num_pending, sizeof(BatchCandidate), compare_batch_candidates);
+    for (int k = 0; k < num_pending; k++) {
+        pending[k] = candidates[k].index;
+    }
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_workers = online > 1 ? (int)online : 1;
+    BatchWorker* workers = (BatchWorker*)malloc(num_workers * sizeof(BatchWorker));
+    pthread_t* threads = (pthread_t*)malloc(num_workers * sizeof(pthread_t));
+    int workers_ready = 0;
+
+    while (num_pending > 0) {
+        int hard_count = 0;
+
+        // Cheap pass against the certificate
+        for (int k = 0; k < num_pending; k++) {
+            int i = pending[k];
+            int* requested = padded + (size_t)i * stride;
+            int* allocated = state_row(state->allocation, state, requests[i].process_id);
+            int* needed = state_row(state->need, state, requests[i].process_id);
+
+            if (!batchFits(state, requests[i].process_id, requested, &results[i])) {
+                continue;
+            }
+
+            row_sub(state->available, requested, stride);
+            row_add(allocated, requested, stride);
+            row_sub(needed, requested, stride);
+
+            if (checkCertificate(state, requests[i].process_id, requested)) {
+                results[i] = REQUEST_GRANTED;
+                continue;
+            }
+
+            row_add(state->available, requested, stride);
+            row_sub(allocated, requested, stride);
+            row_add(needed, requested, stride);
+            hard[hard_count++] = i;
+        }
+
+        // Grants later in the pass may have used up what an earlier
+        // candidate needed
+        int kept = 0;
+        for (int j = 0; j < hard_count; j++) {
+            int i = hard[j];
+            if (batchFits(state, requests[i].process_id, padded + (size_t)i * stride, &results[i])) {
+                hard[kept++] = i;
+            }
+        }
+        hard_count = kept;
+
+        if (hard_count == 0) {
+            break;
+        }
+
+        // Full safety checks for the rest, in parallel
+        int used = hard_count < num_workers ? hard_count : num_workers;
+        int next = 0;
+
+        for (; workers_ready < used; workers_ready++) {
+            init_safety_scratch(&workers[workers_ready].scratch, state->num_processes,
+                                num_resources, stride);
+        }
+        for (int w = 0; w < used; w++) {
+            workers[w].state = state;
+            workers[w].requests = requests;
+            workers[w].padded = padded;
+            workers[w].hard = hard;
+            workers[w].hard_count = hard_count;
+            workers[w].next = &next;
+            workers[w].safe = safe;
+        }
+        for (int w = 1; w < used; w++) {
+            pthread_create(&threads[w], NULL, batch_worker, &workers[w]);
+        }
+        batch_worker(&workers[0]);
+        for (int w = 1; w < used; w++) {
+            pthread_join(threads[w], NULL);
+        }
+
+        // Grant the first safe candidate, retry the other safe ones
+        int granted = -1;
+        num_pending = 0;
+        for (int j = 0; j < hard_count; j++) {
+            int i = hard[j];
+            if (!safe[j]) {
+                results[i] = REQUEST_UNSAFE;
+            } else if (granted < 0) {
+                granted = i;
+            } else {
+                pending[num_pending++] = i;
+            }
+        }
+
+        if (granted >= 0) {
+            int* requested = padded + (size_t)granted * stride;
+            row_sub(state->available, requested, stride);
+            row_add(state_row(state->allocation, state, requests[granted].process_id), requested, stride);
+            row_sub(state_row(state->need, state, requests[granted].process_id), requested, stride);
+            buildCertificate(state);
+            results[granted] = REQUEST_GRANTED;
+        }
+    }
+
+    pthread_rwlock_unlock(&state->lock);
+
+    for (int w = 0; w < workers_ready; w++) {
+        free_safety_scratch(&workers[w].scratch);
+    }
+    free(workers);
+    free(threads);
+    free(padded);
+    free(candidates);
+    free(pending);
+    free(hard);
+    free(safe);
+}
+
+int edge_list_find(const EdgeList* list, int to) {
+    for (int i = 0; i < list->size; i++) {
+        if (list->edges[i].to == to) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void edge_list_append(EdgeList* list, int to) {
+    if (list->size == list->capacity) {
+        list->capacity = list->capacity ? 2 * list->capacity : 4;
+        list->edges = (WaitEdge*)realloc(list->edges, list->capacity * sizeof(WaitEdge));
+    }
+    list->edges[list->size].to = to;
+    list->edges[list->size].count = 1;
+    list->size++;
+}
+
+void edge_list_remove_at(EdgeList* list, int i) {
+    list->edges[i] = list->edges[--list->size];
+}
+
+int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+void init_wait_graph(WaitForGraph* graph, int num_nodes) {
+    graph->num_nodes = num_nodes;
+    graph->out = (EdgeList*)calloc(num_nodes + 1, sizeof(EdgeList));
+    graph->in = (EdgeList*)calloc(num_nodes + 1, sizeof(EdgeList));
+    graph->order = (int*)malloc((num_nodes + 1) * sizeof(int));
+    graph->node_at = (int*)malloc((num_nodes + 1) * sizeof(int));
+    graph->visited = (int*)calloc(num_nodes + 1, sizeof(int));
+    graph->epoch = 0;
+    graph->stack = (int*)malloc((num_nodes + 1) * sizeof(int));
+    graph->forward = (int*)malloc((num_nodes + 1) * sizeof(int));
+    graph->backward = (int*)malloc((num_nodes + 1) * sizeof(int));
+    graph->slots = (int*)malloc((2 * num_nodes + 1) * sizeof(int));
+
+    for (int p = 0; p < num_nodes; p++) {
+        graph->order[p] = p;
+        graph->node_at[p] = p;
+    }
+}
+
+void free_wait_graph(WaitForGraph* graph) {
+    for (int p = 0; p < graph->num_nodes; p++) {
+        free(graph->out[p].edges);
+        free(graph->in[p].edges);
+    }
+    free(graph->out);
+    free(graph->in);
+    free(graph->order);
+    free(graph->node_at);
+    free(graph->visited);
+    free(graph->stack);
+    free(graph->forward);
+    free(graph->backward);
+    free(graph->slots);
+}
+
+// Add the wait from -> to. Returns false, leaving the graph unchanged, if
+// the edge would close a cycle.
+bool wait_graph_add_edge(WaitForGraph* graph, int from, int to) {
+    int* order = graph->order;
+
+    if (from == to) {
+        return false;
+    }
+
+    int i = edge_list_find(&graph->out[from], to);
+    if (i >= 0) {
+        graph->out[from].edges[i].count++;
+        graph->in[to].edges[edge_list_find(&graph->in[to], from)].count++;
+        return true;
+    }
+
+    // An edge that goes against the order disturbs only the processes
+    // between to and from. Search forward from to and backward from from
+    // within that window; reaching from going forward means a cycle.
+    if (order[from] > order[to]) {
+        int lower = order[to];
+        int upper = order[from];
+        int num_forward = 0;
+        int num_backward = 0;
+        int top = 0;
+
+        graph->epoch++;
+        graph->stack[top++] = to;
+        graph->visited[to] = graph->epoch;
+        while (top > 0) {
+            int node = graph->stack[--top];
+            graph->forward[num_forward++] = order[node];
+            for (int e = 0; e < graph->out[node].size; e++) {
+                int next = graph->out[node].edges[e].to;
+                if (next == from) {
+                    return false;
+                }
+                if (graph->visited[next] != graph->epoch && order[next] < upper) {
+                    graph->visited[next] = graph->epoch;
+                    graph->stack[top++] = next;
+                }
+            }
+        }
+
+        graph->stack[top++] = from;
+        graph->visited[from] = graph->epoch;
+        while (top > 0) {
+            int node = graph->stack[--top];
+            graph->backward[num_backward++] = order[node];
+            for (int e = 0; e < graph->in[node].size; e++) {
+                int prev = graph->in[node].edges[e].to;
+                if (graph->visited[prev] != graph->epoch && order[prev] > lower) {
+                    graph->visited[prev] = graph->epoch;
+                    graph->stack[top++] = prev;
+                }
+            }
+        }
+
+        // Reuse the positions of both sets: everything that reaches from
+        // goes first, everything reachable from to goes after it
+        qsort(graph->forward, num_forward, sizeof(int), compare_ints);
+        qsort(graph->backward, num_backward, sizeof(int), compare_ints);
+        for (int k = 0; k < num_backward; k++) {
+            graph->backward[k] = graph->node_at[graph->backward[k]];
+            graph->slots[k] = order[graph->backward[k]];
+        }
+        for (int k = 0; k < num_forward; k++) {
+            graph->forward[k] = graph->node_at[graph->forward[k]];
+            graph->slots[num_backward + k] = order[graph->forward[k]];
+        }
+        qsort(graph->slots, num_backward + num_forward, sizeof(int), compare_ints);
+
+        for (int k = 0; k < num_backward; k++) {
+            order[graph->backward[k]] = graph->slots[k];
+            graph->node_at[graph->slots[k]] = graph->backward[k];
+        }
+        for (int k = 0; k < num_forward; k++) {
+            order[graph->forward[k]] = graph->slots[num_backward + k];
+            graph->node_at[graph->slots[num_backward + k]] = graph->forward[k];
+        }
+    }
+
+    edge_list_append(&graph->out[from], to);
+    edge_list_append(&graph->in[to], from);
+    return true;
+}
+
+// Drop one resource's worth of the wait from -> to
+void wait_graph_remove_edge(WaitForGraph* graph, int from, int to) {
+    int i = edge_list_find(&graph->out[from], to);
+    if (i < 0) {
+        return;
+    }
+
+    int j = edge_list_find(&graph->in[to], from);
+    if (--graph->out[from].edges[i].count == 0) {
+        edge_list_remove_at(&graph->out[from], i);
+        edge_list_remove_at(&graph->in[to], j);
+    } else {
+        graph->in[to].edges[j].count--;
+    }
+}
+
+// Drop every wait of a process
+void wait_graph_clear_out(WaitForGraph* graph, int from) {
+    EdgeList* out = &graph->out[from];
+    for (int e = 0; e < out->size; e++) {
+        EdgeList* in = &graph->in[out->edges[e].to];
+        edge_list_remove_at(in, edge_list_find(in, from));
+    }
+    out->size = 0;
+}
+
+// Mark resources that exist as exactly one instance
+void classify_resources(BankerState* state) {
+    for (int r = 0; r < state->num_resources; r++) {
+        int total = state->available[r];
+        for (int p = 0; p < state->num_processes; p++) {
+            total += state_row(state->allocation, state, p)[r];
+        }
+        state->single_instance[r] = total == 1;
+    }
+}
+
+BankerState* banker_init_detection(int num_processes, int num_resources, const int available[],
+                                   const int allocation[]) {
+    if (num_processes <= 0 || num_resources <= 0) {
+        return NULL;
+    }
+
+    BankerState* state = init_banker_state(num_processes, num_resources);
+    memcpy(state->available, available, num_resources * sizeof(int));
+
+    if (allocation != NULL) {
+        for (int p = 0; p < num_processes; p++) {
+            memcpy(state_row(state->allocation, state, p), allocation + (size_t)p * num_resources,
+                   num_resources * sizeof(int));
+        }
+    }
+
+    classify_resources(state);
+    return state;
+}
+
+// Grant or record a detection-mode request while owning the state and the
+// wait-for graph exclusively
+RequestStatus acquireExclusive(BankerState* state, int process_id, const int request[]) {
+    int stride = state->stride;
+    int* requested = state->request;
+    int* allocated = state_row(state->allocation, state, process_id);
+    int* outstanding = state_row(state->outstanding, state, process_id);
+
+    // Whatever the process waited for before is replaced by this request
+    wait_graph_clear_out(&state->graph, process_id);
+    memset(outstanding, 0, stride * sizeof(int));
+    if (state->waiting[process_id]) {
+        state->waiting[process_id] = false;
+        state->num_blocked--;
+    }
+
+    memcpy(requested, request, state->num_resources * sizeof(int));
+
+    if (row_fits(requested, state->available, stride)) {
+        row_sub(state->available, requested, stride);
+        row_add(allocated, requested, stride);
+
+        // Processes waiting on what was just taken now wait for this one.
+        // It waits for nothing, so these edges cannot close a cycle.
+        for (int r = 0; r < state->num_resources && state->num_blocked > 0; r++) {
+            if (!state->single_instance[r] || requested[r] == 0) {
+                continue;
+            }
+            for (int w = 0; w < state->num_processes; w++) {
+                if (state->waiting[w] && state_row(state->outstanding, state, w)[r] > 0) {
+                    wait_graph_add_edge(&state->graph, w, process_id);
+                }
+            }
+        }
+        return REQUEST_GRANTED;
+    }
+
+    // Wait for the holders of single-instance resources that are taken
+    for (int r = 0; r < state->num_resources; r++) {
+        if (!state->single_instance[r] || requested[r] <= state->available[r]) {
+            continue;
+        }
+        for (int h = 0; h < state->num_processes; h++) {
+            if (state_row(state->allocation, state, h)[r] == 0) {
+                continue;
+            }
+            if (!wait_graph_add_edge(&state->graph, process_id, h)) {
+                wait_graph_clear_out(&state->graph, process_id);
+                return REQUEST_DEADLOCK;
+            }
+            break;
+        }
+    }
+
+    memcpy(outstanding, requested, stride * sizeof(int));
+    state->waiting[process_id] = true;
+    state->num_blocked++;
+    return REQUEST_UNAVAILABLE;
+}
+
+RequestStatus banker_acquire(BankerState* state, int process_id, const int request[]) {
+    int num_resources = state->num_resources;
+    bool fast = true;
+    int taken = 0;
+
+    if (process_id < 0 || process_id >= state->num_processes) {
+        return REQUEST_INVALID;
+    }
+    for (int r = 0; r < num_resources; r++) {
+        if (request[r] < 0) {
+            return REQUEST_INVALID;
+        }
+    }
+
+    pthread_rwlock_rdlock(&state->lock);
+    pthread_mutex_lock(&state->process_locks[process_id]);
+
+    // The graph only needs updating if this process was waiting, or if it
+    // takes a single-instance resource someone else is waiting on
+    if (state->waiting[process_id]) {
+        fast = false;
+    }
+    for (int r = 0; r < num_resources && fast && state->num_blocked > 0; r++) {
+        if (state->single_instance[r] && request[r] > 0) {
+            fast = false;
+        }
+    }
+
+    for (; taken < num_resources && fast; taken++) {
+        if (request[taken] > 0 && !try_take(&state->available[taken], request[taken])) {
+            fast = false;
+            break;
+        }
+    }
+
+    int* allocated = state_row(state->allocation, state, process_id);
+    if (fast) {
+        for (int r = 0; r < num_resources; r++) {
+            allocated[r] += request[r];
+        }
+    } else {
+        for (int r = 0; r < taken; r++) {
+            __atomic_add_fetch(&state->available[r], request[r], __ATOMIC_RELEASE);
+        }
+    }
+
+    pthread_mutex_unlock(&state->process_locks[process_id]);
+    pthread_rwlock_unlock(&state->lock);
+
+    if (fast) {
+        return REQUEST_GRANTED;
+    }
+
+    pthread_rwlock_wrlock(&state->lock);
+    pthread_mutex_lock(&state->graph_lock);
+    RequestStatus status = acquireExclusive(state, process_id, request);
+    pthread_mutex_unlock(&state->graph_lock);
+    pthread_rwlock_unlock(&state->lock);
+    return status;
+}
+
+// Multi-instance deadlock detection: the safety algorithm run on the
+// outstanding requests instead of the remaining claims. Processes that can
+// never get what they are waiting for, and hold something, are
+// deadlocked. Returns how many there are; deadlocked may be NULL.
+int banker_detect_deadlock(BankerState* state, bool deadlocked[]) {
+    int num_deadlocked = 0;
+
+    pthread_rwlock_wrlock(&state->lock);
+    pthread_mutex_lock(&state->graph_lock);
+
+    reduceProcesses(state, &state->scratch, state->outstanding, -1, NULL,
+                    state->scratch.sequence);
+
+    for (int p = 0; p < state->num_processes; p++) {
+        const int* allocated = state_row(state->allocation, state, p);
+        bool holds = false;
+
+        for (int r = 0; r < state->num_resources && !holds; r++) {
+            holds = allocated[r] > 0;
+        }
+
+        bool stuck = state->scratch.blocked[p] > 0 && holds;
+        if (deadlocked != NULL) {
+            deadlocked[p] = stuck;
+        }
+        num_deadlocked += stuck;
+    }
+
+    pthread_mutex_unlock(&state->graph_lock);
+    pthread_rwlock_unlock(&state->lock);
+    return num_deadlocked;
+}
@@ -0,0 +1,231 @@
+#ifndef BANKER_H
+#define BANKER_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+// Every matrix row is padded to a whole number of cache lines so rows start
+// 64-byte aligned and the vector kernels never need a remainder loop.
+// Padding lanes are always 0, which keeps them neutral in every kernel.
+#define CACHE_LINE 64
+#define INTS_PER_LINE ((int)(CACHE_LINE / sizeof(int)))
+
+// One outstanding need of a process on a single resource
+typedef struct {
+    int amount;
+    int process;
+} NeedEntry;
+
+// Binary min-heap of process IDs that are ready to finish
+typedef struct {
+    int* items;
+    int size;
+} ProcessHeap;
+
+// Working memory for one safety check. The state owns one for exclusive
+// use; batch admission gives each worker thread its own.
+typedef struct {
+    int* work;
+    int* sequence;
+    int* cursor;
+    int* blocked;
+    NeedEntry* needs;
+    ProcessHeap this_pass;
+    ProcessHeap next_pass;
+} SafetyScratch;
+
+// Last proven safe sequence, kept so later requests can be re-validated
+// without recomputing the whole safety check
+typedef struct {
+    bool valid;
+    int* sequence;
+    int* position;  // Index of each process in sequence
+    int* slack;     // Lower bound of work - need along sequence (one row)
+} SafetyCertificate;
+
+// Edge of the wait-for graph. count is the number of single-instance
+// resources the waiting process wants from the holder.
+typedef struct {
+    int to;
+    int count;
+} WaitEdge;
+
+typedef struct {
+    WaitEdge* edges;
+    int size;
+    int capacity;
+} EdgeList;
+
+// Wait-for graph over single-instance resources. A topological order of
+// the processes is kept up to date as edges arrive (Pearce-Kelly), so an
+// edge that agrees with the order costs O(1), and any other edge only
+// searches the processes ordered between its two ends.
+typedef struct {
+    int num_nodes;
+    EdgeList* out;
+    EdgeList* in;
+    int* order;       // Topological position of each process
+    int* node_at;     // Process at each position
+    int* visited;     // Search epoch each process was last reached in
+    int epoch;
+    int* stack;
+    int* forward;     // Positions reached by the forward search
+    int* backward;    // Positions reached by the backward search
+    int* slots;
+} WaitForGraph;
+
+// Order in which parked requests are retried after a release
+typedef enum {
+    WAKE_FIFO,            // Arrival order
+    WAKE_SMALLEST_FIRST,  // Fewest total units first
+    WAKE_MAX_GRANTED      // Smallest share of what is available first
+} WakePolicy;
+
+// A request parked in banker_request_wait until a release lets it through
+typedef struct PendingRequest {
+    int process_id;
+    const int* request;
+    unsigned long arrival;
+    double key;           // Ordering key for the current wake-up pass
+    bool done;
+    int status;           // RequestStatus once done
+    pthread_cond_t wakeup;
+    struct PendingRequest* next;
+} PendingRequest;
+
+// Banker's algorithm state. max, allocation and need are separate
+// row-major matrices of num_processes rows, each row stride ints long.
+typedef struct {
+    int num_processes;
+    int num_resources;
+    int stride;
+    int* available;
+    int* max;
+    int* allocation;
+    int* need;
+    SafetyCertificate cert;
+
+    // Requests and releases that fit the certificate hold lock for reading
+    // plus the lock of their own process. Anything that needs a consistent
+    // view of the whole state (full safety checks, rollbacks of a tentative
+    // grant) holds lock for writing.
+    pthread_rwlock_t lock;
+    pthread_mutex_t* process_locks;
+
+    // Parked requests in arrival order, protected by wait_lock
+    pthread_mutex_t wait_lock;
+    PendingRequest* waiting_head;
+    PendingRequest* waiting_tail;
+    int num_waiting;
+    unsigned long arrivals;
+    unsigned long release_epoch;
+    WakePolicy wake_policy;
+
+    // Detection mode, protected by graph_lock (taken after lock):
+    // outstanding requests of blocked processes and the wait-for graph
+    // over resources that have a single instance
+    pthread_mutex_t graph_lock;
+    int* outstanding;
+    bool* waiting;
+    int num_blocked;
+    bool* single_instance;
+    WaitForGraph graph;
+
+    // Scratch space reused by every safety check, only touched while lock
+    // is held for writing
+    SafetyScratch scratch;
+    int* slack;
+    int* request;
+} BankerState;
+
+// Outcome of a resource request
+typedef enum {
+    REQUEST_GRANTED,
+    REQUEST_EXCEEDS_CLAIM,   // Request is larger than the remaining need
+    REQUEST_UNAVAILABLE,     // Not enough resources available right now
+    REQUEST_UNSAFE,          // Granting would leave the system unsafe
+    REQUEST_INVALID,         // Bad process ID or negative amount
+    REQUEST_DEADLOCK         // Waiting would close a cycle in the wait-for graph
+} RequestStatus;
+
+// One request in a batch passed to banker_request_batch
+typedef struct {
+    int process_id;
+    const int* request;
+} BatchRequest;
+
+// Thread-safe resource manager API. Every function below may be called
+// from any number of threads at once on the same state.
+
+// Create a manager from row-major num_processes x num_resources max and
+// allocation matrices. Returns NULL if an allocation exceeds its claim or
+// the initial state is unsafe.
+BankerState* banker_init(int num_processes, int num_resources, const int available[],
+                         const int max[], const int allocation[]);
+RequestStatus banker_request(BankerState* state, int process_id, const int request[]);
+bool banker_release(BankerState* state, int process_id, const int release[]);
+
+// Like banker_request, but instead of failing with REQUEST_UNAVAILABLE or
+// REQUEST_UNSAFE the caller sleeps until a release lets the request be
+// granted safely. Invalid requests still fail immediately.
+RequestStatus banker_request_wait(BankerState* state, int process_id, const int request[]);
+void banker_set_wake_policy(BankerState* state, WakePolicy policy);
+
+// Admit count requests at once, granting a maximal subset that keeps the
+// system safe. results[i] receives the outcome of requests[i].
+void banker_request_batch(BankerState* state, int count, const BatchRequest requests[],
+                          RequestStatus results[]);
+void banker_query(BankerState* state, int process_id, int allocation[], int need[]);
+void banker_query_available(BankerState* state, int available[]);
+bool banker_is_safe(BankerState* state, int safe_sequence[]);
+
+// Detection mode, for workloads whose maximum claims are unknown. A state
+// made by banker_init_detection grants with banker_acquire whenever the
+// resources are free, with no avoidance check. A request that has to wait
+// is recorded and REQUEST_UNAVAILABLE is returned; the caller retries after
+// releases. Waits on single-instance resources are checked for cycles as
+// they are recorded, and REQUEST_DEADLOCK is returned instead of waiting
+// when one would form. banker_detect_deadlock runs the full multi-instance
+// detection algorithm over all recorded waits. allocation may be NULL.
+BankerState* banker_init_detection(int num_processes, int num_resources, const int available[],
+                                   const int allocation[]);
+RequestStatus banker_acquire(BankerState* state, int process_id, const int request[]);
+int banker_detect_deadlock(BankerState* state, bool deadlocked[]);
+void banker_destroy(BankerState* state);
+
+// Lower-level pieces, not synchronized. Callers must own the state
+// exclusively (single-threaded use, or lock held for writing).
+BankerState* init_banker_state(int num_processes, int num_resources);
+void free_banker_state(BankerState* state);
+int* alloc_rows(int count, int stride);
+int* state_row(int* matrix, const BankerState* state, int process);
+
+bool row_fits(const int* row, const int* work, int stride);
+void row_add(int* dst, const int* src, int stride);
+void row_sub(int* dst, const int* src, int stride);
+void row_min_slack(int* slack, const int* work, const int* need, int stride);
+
+void init_safety_scratch(SafetyScratch* scratch, int num_processes, int num_resources, int stride);
+void free_safety_scratch(SafetyScratch* scratch);
+int reduceProcesses(const BankerState* state, SafetyScratch* scratch, const int* demand,
+                    int delta_process, const int delta[], int sequence[]);
+bool findSafeSequenceWith(const BankerState* state, SafetyScratch* scratch,
+                          int delta_process, const int delta[], int safe_sequence[]);
+bool findSafeSequence(BankerState* state, int safe_sequence[]);
+bool findCertificate(BankerState* state);
+bool buildCertificate(BankerState* state);
+bool checkCertificate(BankerState* state, int process_id, const int request[]);
+bool revalidateCertificate(BankerState* state, int process_id, const int request[]);
+RequestStatus requestExclusive(BankerState* state, int process_id, const int request[]);
+void grantWaiters(BankerState* state);
+RequestStatus acquireExclusive(BankerState* state, int process_id, const int request[]);
+void classify_resources(BankerState* state);
+
+void init_wait_graph(WaitForGraph* graph, int num_nodes);
+void free_wait_graph(WaitForGraph* graph);
+bool wait_graph_add_edge(WaitForGraph* graph, int from, int to);
+void wait_graph_remove_edge(WaitForGraph* graph, int from, int to);
+void wait_graph_clear_out(WaitForGraph* graph, int from);
+bool batchFits(BankerState* state, int process_id, const int requested[], RequestStatus* status);
+
+#endif
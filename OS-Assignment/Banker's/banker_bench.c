@@ -0,0 +1,543 @@
+// Non-interactive benchmark for the Banker's algorithm library. Replays a
+// request/release trace from a file, or generates a random workload, and
+// reports throughput, request and safety-check latency, and grant ratio.
+// Build: gcc -O2 banker_bench.c banker.c -pthread
+//
+// Usage:
+//   banker_bench trace FILE
+//   banker_bench synth [-p processes] [-r resources] [-n ops] [-c claims]
+//                      [-l contention] [-k check_every] [-s seed] [-w FILE]
+//
+// claims is uniform, skewed or fixed. contention runs from 0 (enough of
+// every resource for all claims at once) to 1 (only as much as the largest
+// single claim). -w writes the generated trace to FILE instead of running.
+//
+// Trace format, one item per line, # starts a comment:
+//   processes N
+//   resources M
+//   available a0 .. aM-1
+//   max P c0 .. cM-1          (once per process)
+//   allocation P a0 .. aM-1   (optional, defaults to zero)
+//   request P r0 .. rM-1
+//   release P r0 .. rM-1
+//   check                     (run the safety algorithm)
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "banker.h"
+
+#define CLAIM_CAP 10
+
+typedef enum {
+    OP_REQUEST,
+    OP_RELEASE,
+    OP_CHECK
+} OpType;
+
+// Workload to replay: the initial state and the operations, whose amounts
+// are stored num_resources per operation in values
+typedef struct {
+    int num_processes;
+    int num_resources;
+    int* available;
+    int* max;
+    int* allocation;
+
+    int num_ops;
+    int capacity;
+    OpType* types;
+    int* process_ids;
+    int* values;
+} Trace;
+
+typedef struct {
+    int num_processes;
+    int num_resources;
+    int num_ops;
+    const char* claims;
+    double contention;
+    int check_every;
+    unsigned long long seed;
+    const char* output;
+} SynthOptions;
+
+static unsigned long long rng_state = 1;
+
+// xorshift64*, so a seed gives the same workload everywhere
+unsigned long long nextRandom() {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+
+int randomBelow(int bound) {
+    return (int)(nextRandom() % (unsigned long long)bound);
+}
+
+double randomUnit() {
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+long long nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void initTrace(Trace* trace, int num_processes, int num_resources) {
+    memset(trace, 0, sizeof(Trace));
+    trace->num_processes = num_processes;
+    trace->num_resources = num_resources;
+    trace->available = (int*)calloc(num_resources, sizeof(int));
+    trace->max = (int*)calloc((size_t)num_processes * num_resources, sizeof(int));
+    trace->allocation = (int*)calloc((size_t)num_processes * num_resources, sizeof(int));
+}
+
+void freeTrace(Trace* trace) {
+    free(trace->available);
+    free(trace->max);
+    free(trace->allocation);
+    free(trace->types);
+    free(trace->process_ids);
+    free(trace->values);
+}
+
+// Append an operation and return where its amounts go
+int* addOp(Trace* trace, OpType type, int process_id) {
+    if (trace->num_ops == trace->capacity) {
+        trace->capacity = trace->capacity ? 2 * trace->capacity : 1024;
+        trace->types = (OpType*)realloc(trace->types, trace->capacity * sizeof(OpType));
+        trace->process_ids = (int*)realloc(trace->process_ids, trace->capacity * sizeof(int));
+        trace->values = (int*)realloc(trace->values,
+                                      (size_t)trace->capacity * trace->num_resources * sizeof(int));
+    }
+
+    int i = trace->num_ops++;
+    trace->types[i] = type;
+    trace->process_ids[i] = process_id;
+
+    int* amounts = trace->values + (size_t)i * trace->num_resources;
+    memset(amounts, 0, trace->num_resources * sizeof(int));
+    return amounts;
+}
+
+// Read num_resources integers following the keyword on a trace line
+bool readAmounts(char** cursor, int amounts[], int num_resources) {
+    for (int r = 0; r < num_resources; r++) {
+        char* end;
+        long value = strtol(*cursor, &end, 10);
+        if (end == *cursor) {
+            return false;
+        }
+        amounts[r] = (int)value;
+        *cursor = end;
+    }
+    return true;
+}
+
+bool loadTrace(const char* path, Trace* trace) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open trace %s\n", path);
+        return false;
+    }
+
+    char line[4096];
+    int line_number = 0;
+    int num_processes = 0;
+    int num_resources = 0;
+    bool ready = false;
+    bool ok = true;
+
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        char keyword[32];
+        int consumed;
+        line_number++;
+
+        char* comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+        if (sscanf(line, "%31s%n", keyword, &consumed) != 1) {
+            continue;
+        }
+        char* cursor = line + consumed;
+
+        bool sizes = strcmp(keyword, "processes") == 0 || strcmp(keyword, "resources") == 0;
+        if (sizes && ready) {
+            // The arrays are already sized
+            printf("Error: %s:%d: processes and resources must come first\n", path, line_number);
+            ok = false;
+            break;
+        } else if (strcmp(keyword, "processes") == 0) {
+            num_processes = (int)strtol(cursor, NULL, 10);
+        } else if (strcmp(keyword, "resources") == 0) {
+            num_resources = (int)strtol(cursor, NULL, 10);
+        } else {
+            if (!ready) {
+                if (num_processes <= 0 || num_resources <= 0) {
+                    printf("Error: %s:%d: processes and resources must come first\n", path,
+                           line_number);
+                    ok = false;
+                    break;
+                }
+                initTrace(trace, num_processes, num_resources);
+                ready = true;
+            }
+
+            if (strcmp(keyword, "check") == 0) {
+                addOp(trace, OP_CHECK, 0);
+                continue;
+            }
+            if (strcmp(keyword, "available") == 0) {
+                ok = readAmounts(&cursor, trace->available, num_resources);
+                continue;
+            }
+
+            char* end;
+            int process_id = (int)strtol(cursor, &end, 10);
+            if (end == cursor || process_id < 0 || process_id >= num_processes) {
+                ok = false;
+            } else if (strcmp(keyword, "max") == 0) {
+                ok = readAmounts(&end, trace->max + (size_t)process_id * num_resources,
+                                 num_resources);
+            } else if (strcmp(keyword, "allocation") == 0) {
+                ok = readAmounts(&end, trace->allocation + (size_t)process_id * num_resources,
+                                 num_resources);
+            } else if (strcmp(keyword, "request") == 0) {
+                ok = readAmounts(&end, addOp(trace, OP_REQUEST, process_id), num_resources);
+            } else if (strcmp(keyword, "release") == 0) {
+                ok = readAmounts(&end, addOp(trace, OP_RELEASE, process_id), num_resources);
+            } else {
+                ok = false;
+            }
+        }
+
+        if (!ok) {
+            printf("Error: %s:%d: malformed line\n", path, line_number);
+        }
+    }
+
+    fclose(file);
+    if (ok && !ready) {
+        printf("Error: %s: empty trace\n", path);
+        ok = false;
+    }
+    if (!ok && ready) {
+        freeTrace(trace);
+    }
+    return ok;
+}
+
+void writeAmounts(FILE* file, const int amounts[], int num_resources) {
+    for (int r = 0; r < num_resources; r++) {
+        fprintf(file, " %d", amounts[r]);
+    }
+    fprintf(file, "\n");
+}
+
+bool saveTrace(const char* path, const Trace* trace) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Error: Cannot write trace %s\n", path);
+        return false;
+    }
+
+    int m = trace->num_resources;
+    fprintf(file, "processes %d\nresources %d\navailable", trace->num_processes, m);
+    writeAmounts(file, trace->available, m);
+    for (int p = 0; p < trace->num_processes; p++) {
+        fprintf(file, "max %d", p);
+        writeAmounts(file, trace->max + (size_t)p * m, m);
+    }
+
+    for (int i = 0; i < trace->num_ops; i++) {
+        const int* amounts = trace->values + (size_t)i * m;
+        switch (trace->types[i]) {
+            case OP_REQUEST:
+                fprintf(file, "request %d", trace->process_ids[i]);
+                writeAmounts(file, amounts, m);
+                break;
+            case OP_RELEASE:
+                fprintf(file, "release %d", trace->process_ids[i]);
+                writeAmounts(file, amounts, m);
+                break;
+            default:
+                fprintf(file, "check\n");
+                break;
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+// Draw a maximum claim for one process and resource
+int drawClaim(const char* claims) {
+    if (strcmp(claims, "fixed") == 0) {
+        return CLAIM_CAP;
+    }
+    if (strcmp(claims, "skewed") == 0) {
+        // Mostly small claims with a few large ones
+        double u = randomUnit();
+        return (int)(u * u * u * CLAIM_CAP + 0.5);
+    }
+    return randomBelow(CLAIM_CAP + 1);
+}
+
+bool validClaims(const char* claims) {
+    return strcmp(claims, "uniform") == 0 || strcmp(claims, "skewed") == 0 ||
+           strcmp(claims, "fixed") == 0;
+}
+
+// Build a random workload. The operations are generated against a shadow
+// manager, so releases only return what a process really holds and the
+// trace replays to the same outcomes.
+bool generateTrace(const SynthOptions* options, Trace* trace) {
+    int n = options->num_processes;
+    int m = options->num_resources;
+
+    rng_state = options->seed ? options->seed : 1;
+    initTrace(trace, n, m);
+
+    // Redraw claims that are all zero: no process would ever request
+    // anything and the workload could not make progress
+    bool any_claim = false;
+    while (!any_claim) {
+        for (int r = 0; r < m; r++) {
+            for (int p = 0; p < n; p++) {
+                int claim = drawClaim(options->claims);
+                trace->max[(size_t)p * m + r] = claim;
+                any_claim |= claim > 0;
+            }
+        }
+    }
+
+    // Size each resource between the largest claim (contention 1) and the
+    // sum of all claims (contention 0)
+    for (int r = 0; r < m; r++) {
+        int sum = 0;
+        int largest = 0;
+        for (int p = 0; p < n; p++) {
+            int claim = trace->max[(size_t)p * m + r];
+            sum += claim;
+            if (claim > largest) {
+                largest = claim;
+            }
+        }
+        trace->available[r] = largest + (int)((1.0 - options->contention) * (sum - largest) + 0.5);
+    }
+
+    BankerState* shadow = banker_init(n, m, trace->available, trace->max, trace->allocation);
+    if (shadow == NULL) {
+        printf("Error: Generated initial state is unsafe\n");
+        freeTrace(trace);
+        return false;
+    }
+
+    int* allocation = (int*)malloc(m * sizeof(int));
+    int* need = (int*)malloc(m * sizeof(int));
+
+    for (int i = 0; i < options->num_ops; i++) {
+        if (options->check_every > 0 && i % options->check_every == options->check_every - 1) {
+            addOp(trace, OP_CHECK, 0);
+            continue;
+        }
+
+        // A process that neither holds nor needs anything has no claim at
+        // all; take the next one that does. Some process always has one.
+        int process_id = randomBelow(n);
+        bool holds = false;
+        bool needs = false;
+
+        for (int k = 0; k < n && !holds && !needs; k++) {
+            process_id = (process_id + (k > 0)) % n;
+            banker_query(shadow, process_id, allocation, need);
+            for (int r = 0; r < m; r++) {
+                holds |= allocation[r] > 0;
+                needs |= need[r] > 0;
+            }
+        }
+
+        // Release when the process has nothing left to ask for, and now and
+        // then before that. Finishing processes give everything back.
+        if (holds && (!needs || randomUnit() < 0.3)) {
+            int* amounts = addOp(trace, OP_RELEASE, process_id);
+            bool finish = !needs || randomUnit() < 0.5;
+            for (int r = 0; r < m; r++) {
+                amounts[r] = finish ? allocation[r] : randomBelow(allocation[r] + 1);
+            }
+            banker_release(shadow, process_id, amounts);
+        } else if (needs) {
+            int* amounts = addOp(trace, OP_REQUEST, process_id);
+            for (int r = 0; r < m; r++) {
+                if (need[r] > 0 && randomUnit() < 0.5) {
+                    amounts[r] = 1 + randomBelow(need[r]);
+                }
+            }
+            banker_request(shadow, process_id, amounts);
+        }
+    }
+
+    free(allocation);
+    free(need);
+    banker_destroy(shadow);
+    return true;
+}
+
+int compareNanos(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+long long percentile(const long long sorted[], int count, int p) {
+    if (count == 0) {
+        return 0;
+    }
+    return sorted[(long long)p * (count - 1) / 100];
+}
+
+void printLatency(const char* name, long long samples[], int count) {
+    qsort(samples, count, sizeof(long long), compareNanos);
+    printf("%-18s %10d calls  p50 %8lld ns  p99 %8lld ns  max %8lld ns\n", name, count,
+           percentile(samples, count, 50), percentile(samples, count, 99),
+           count ? samples[count - 1] : 0);
+}
+
+// Replay a trace against a fresh manager and print the measurements
+bool runTrace(const Trace* trace) {
+    int m = trace->num_resources;
+    BankerState* state = banker_init(trace->num_processes, m, trace->available, trace->max,
+                                     trace->allocation);
+    if (state == NULL) {
+        printf("Error: Initial state of the trace is invalid or unsafe\n");
+        return false;
+    }
+
+    long long* request_nanos = (long long*)malloc((trace->num_ops + 1) * sizeof(long long));
+    long long* check_nanos = (long long*)malloc((trace->num_ops + 1) * sizeof(long long));
+    int* safe_sequence = (int*)malloc(trace->num_processes * sizeof(int));
+    int outcomes[REQUEST_DEADLOCK + 1] = {0};
+    int num_requests = 0;
+    int num_checks = 0;
+    int num_releases = 0;
+    int failed_releases = 0;
+    int unsafe_checks = 0;
+
+    long long start = nowNanos();
+    for (int i = 0; i < trace->num_ops; i++) {
+        const int* amounts = trace->values + (size_t)i * m;
+        int process_id = trace->process_ids[i];
+        long long begin = nowNanos();
+
+        switch (trace->types[i]) {
+            case OP_REQUEST:
+                outcomes[banker_request(state, process_id, amounts)]++;
+                request_nanos[num_requests++] = nowNanos() - begin;
+                break;
+            case OP_RELEASE:
+                failed_releases += !banker_release(state, process_id, amounts);
+                num_releases++;
+                break;
+            default:
+                unsafe_checks += !banker_is_safe(state, safe_sequence);
+                check_nanos[num_checks++] = nowNanos() - begin;
+                break;
+        }
+    }
+    double seconds = (nowNanos() - start) / 1e9;
+
+    printf("processes %d, resources %d, operations %d in %.3f s\n", trace->num_processes, m,
+           trace->num_ops, seconds);
+    printf("throughput         %.0f requests/s, %.0f ops/s\n",
+           seconds > 0 ? num_requests / seconds : 0.0,
+           seconds > 0 ? trace->num_ops / seconds : 0.0);
+    printf("grant ratio        %.2f%% (%d of %d)\n",
+           num_requests ? 100.0 * outcomes[REQUEST_GRANTED] / num_requests : 0.0,
+           outcomes[REQUEST_GRANTED], num_requests);
+    printf("denied             exceeds claim %d, unavailable %d, unsafe %d, invalid %d\n",
+           outcomes[REQUEST_EXCEEDS_CLAIM], outcomes[REQUEST_UNAVAILABLE],
+           outcomes[REQUEST_UNSAFE], outcomes[REQUEST_INVALID]);
+    printf("releases           %d (%d rejected)\n", num_releases, failed_releases);
+    printLatency("requestResources", request_nanos, num_requests);
+    printLatency("isSafe", check_nanos, num_checks);
+    if (unsafe_checks > 0) {
+        printf("Error: %d safety checks found the state unsafe\n", unsafe_checks);
+    }
+
+    free(request_nanos);
+    free(check_nanos);
+    free(safe_sequence);
+    banker_destroy(state);
+    return unsafe_checks == 0;
+}
+
+void printUsage(const char* program) {
+    printf("Usage: %s trace FILE\n", program);
+    printf("       %s synth [-p processes] [-r resources] [-n ops] [-c uniform|skewed|fixed]\n"
+           "             [-l contention] [-k check_every] [-s seed] [-w FILE]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    Trace trace;
+
+    if (argc == 3 && strcmp(argv[1], "trace") == 0) {
+        if (!loadTrace(argv[2], &trace)) {
+            return 1;
+        }
+    } else if (argc >= 2 && strcmp(argv[1], "synth") == 0) {
+        SynthOptions options = {16, 4, 100000, "uniform", 0.5, 100, 1, NULL};
+
+        for (int i = 2; i < argc; i++) {
+            if (i + 1 >= argc || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            const char* value = argv[++i];
+            switch (argv[i - 1][1]) {
+                case 'p': options.num_processes = atoi(value); break;
+                case 'r': options.num_resources = atoi(value); break;
+                case 'n': options.num_ops = atoi(value); break;
+                case 'c': options.claims = value; break;
+                case 'l': options.contention = atof(value); break;
+                case 'k': options.check_every = atoi(value); break;
+                case 's': options.seed = strtoull(value, NULL, 10); break;
+                case 'w': options.output = value; break;
+                default:
+                    printUsage(argv[0]);
+                    return 1;
+            }
+        }
+
+        if (options.num_processes <= 0 || options.num_resources <= 0 || options.num_ops < 0 ||
+            options.contention < 0 || options.contention > 1) {
+            printf("Error: Invalid workload parameters\n");
+            return 1;
+        }
+        if (!validClaims(options.claims)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (!generateTrace(&options, &trace)) {
+            return 1;
+        }
+        if (options.output != NULL) {
+            bool saved = saveTrace(options.output, &trace);
+            freeTrace(&trace);
+            return saved ? 0 : 1;
+        }
+    } else {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    bool ok = runTrace(&trace);
+    freeTrace(&trace);
+    return ok ? 0 : 1;
+}
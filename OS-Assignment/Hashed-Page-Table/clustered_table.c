@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clustered_table.h"
+
+#define INITIAL_BLOCKS 16
+
+ClusteredPageTable* init_clustered_table(void) {
+    ClusteredPageTable* table = (ClusteredPageTable*)calloc(1, sizeof(ClusteredPageTable));
+    table->clusters = init_page_table(0, 0);
+    table->superpages = init_page_table(0, 0);
+    table->block_capacity = INITIAL_BLOCKS;
+    table->frames = (int*)aligned_alloc(CACHE_LINE, INITIAL_BLOCKS * CLUSTER_PAGES * sizeof(int));
+    table->valid = (unsigned short*)malloc(INITIAL_BLOCKS * sizeof(unsigned short));
+    table->free_blocks = (int*)malloc(INITIAL_BLOCKS * sizeof(int));
+    return table;
+}
+
+// Take a block for a new cluster, reusing a released one if there is one
+static int alloc_block(ClusteredPageTable* table) {
+    if (table->num_free > 0) {
+        return table->free_blocks[--table->num_free];
+    }
+
+    if (table->num_blocks == table->block_capacity) {
+        int capacity = table->block_capacity * 2;
+        int* frames = (int*)aligned_alloc(CACHE_LINE, (size_t)capacity * CLUSTER_PAGES * sizeof(int));
+
+        memcpy(frames, table->frames, (size_t)table->num_blocks * CLUSTER_PAGES * sizeof(int));
+        free(table->frames);
+        table->frames = frames;
+        table->valid = (unsigned short*)realloc(table->valid, capacity * sizeof(unsigned short));
+        table->free_blocks = (int*)realloc(table->free_blocks, capacity * sizeof(int));
+        table->block_capacity = capacity;
+    }
+
+    return table->num_blocks++;
+}
+
+// Whether a base page falls inside a mapped superpage
+static bool in_superpage(ClusteredPageTable* table, int virtual_page) {
+    return table->num_superpages > 0 &&
+           lookup_page(table->superpages, virtual_page >> SUPERPAGE_SHIFT) != INVALID_PAGE;
+}
+
+// Map one base page. Fails if the page is covered by a superpage.
+bool clustered_insert(ClusteredPageTable* table, int virtual_page, int physical_frame) {
+    if (physical_frame == INVALID_PAGE || in_superpage(table, virtual_page)) {
+        printf("Warning: Virtual page %d cannot be mapped to frame %d\n", virtual_page,
+               physical_frame);
+        return false;
+    }
+
+    int cluster = virtual_page >> CLUSTER_SHIFT;
+    int offset = virtual_page & (CLUSTER_PAGES - 1);
+    int block = lookup_page(table->clusters, cluster);
+
+    if (block == INVALID_PAGE) {
+        block = alloc_block(table);
+        table->valid[block] = 0;
+        insert_page(table->clusters, cluster, block);
+    }
+
+    if (!(table->valid[block] & (1u << offset))) {
+        table->valid[block] |= (unsigned short)(1u << offset);
+        table->num_pages++;
+    }
+    table->frames[(size_t)block * CLUSTER_PAGES + offset] = physical_frame;
+    return true;
+}
+
+// Map the 2 MiB region starting at virtual_page, which must be superpage
+// aligned, to SUPERPAGE_PAGES frames starting at first_frame. Fails if any
+// page of the region is already mapped on its own.
+bool clustered_insert_superpage(ClusteredPageTable* table, int virtual_page, int first_frame) {
+    if ((virtual_page & (SUPERPAGE_PAGES - 1)) != 0 || first_frame < 0) {
+        printf("Warning: Cannot map superpage at %d (must be aligned to %d pages)\n",
+               virtual_page, SUPERPAGE_PAGES);
+        return false;
+    }
+
+    for (int page = 0; page < SUPERPAGE_PAGES; page += CLUSTER_PAGES) {
+        if (lookup_page(table->clusters, (virtual_page + page) >> CLUSTER_SHIFT) != INVALID_PAGE) {
+            printf("Warning: Superpage at %d overlaps mapped pages\n", virtual_page);
+            return false;
+        }
+    }
+
+    int superpage = virtual_page >> SUPERPAGE_SHIFT;
+    if (lookup_page(table->superpages, superpage) == INVALID_PAGE) {
+        table->num_superpages++;
+    }
+    insert_page(table->superpages, superpage, first_frame);
+    return true;
+}
+
+// Translate a virtual page through the superpages and then the clusters
+int clustered_lookup(ClusteredPageTable* table, int virtual_page) {
+    if (table->num_superpages > 0) {
+        int first_frame = lookup_page(table->superpages, virtual_page >> SUPERPAGE_SHIFT);
+        if (first_frame != INVALID_PAGE) {
+            return first_frame + (virtual_page & (SUPERPAGE_PAGES - 1));
+        }
+    }
+
+    int block = lookup_page(table->clusters, virtual_page >> CLUSTER_SHIFT);
+    if (block == INVALID_PAGE) {
+        return INVALID_PAGE;
+    }
+
+    int offset = virtual_page & (CLUSTER_PAGES - 1);
+    if (!(table->valid[block] & (1u << offset))) {
+        return INVALID_PAGE;
+    }
+    return table->frames[(size_t)block * CLUSTER_PAGES + offset];
+}
+
+// Unmap one base page, releasing its block once the cluster is empty
+bool clustered_remove(ClusteredPageTable* table, int virtual_page) {
+    int cluster = virtual_page >> CLUSTER_SHIFT;
+    int offset = virtual_page & (CLUSTER_PAGES - 1);
+    int block = lookup_page(table->clusters, cluster);
+
+    if (block == INVALID_PAGE || !(table->valid[block] & (1u << offset))) {
+        return false;
+    }
+
+    table->valid[block] &= (unsigned short)~(1u << offset);
+    table->num_pages--;
+
+    if (table->valid[block] == 0) {
+        remove_page(table->clusters, cluster);
+        table->free_blocks[table->num_free++] = block;
+    }
+    return true;
+}
+
+bool clustered_remove_superpage(ClusteredPageTable* table, int virtual_page) {
+    if (!remove_page(table->superpages, virtual_page >> SUPERPAGE_SHIFT)) {
+        return false;
+    }
+    table->num_superpages--;
+    return true;
+}
+
+size_t clustered_table_bytes(const ClusteredPageTable* table) {
+    size_t per_block = CLUSTER_PAGES * sizeof(int) + sizeof(unsigned short) + sizeof(int);
+    return sizeof(ClusteredPageTable) + page_table_bytes(table->clusters) +
+           page_table_bytes(table->superpages) + (size_t)table->block_capacity * per_block;
+}
+
+void print_clustered_stats(const ClusteredPageTable* table) {
+    long long pages = table->num_pages + (long long)table->num_superpages * SUPERPAGE_PAGES;
+
+    printf("\nClustered Page Table Status:\n");
+    printf("----------------------------------------\n");
+    printf("Base pages: %d in %d clusters of %d\n", table->num_pages,
+           table->num_blocks - table->num_free, CLUSTER_PAGES);
+    printf("Superpages: %d of %d pages\n", table->num_superpages, SUPERPAGE_PAGES);
+    printf("Memory: %zu bytes, %.2f bytes per mapped page\n", clustered_table_bytes(table),
+           pages ? (double)clustered_table_bytes(table) / pages : 0.0);
+}
+
+void free_clustered_table(ClusteredPageTable* table) {
+    free_page_table(table->clusters);
+    free_page_table(table->superpages);
+    free(table->frames);
+    free(table->valid);
+    free(table->free_blocks);
+    free(table);
+}
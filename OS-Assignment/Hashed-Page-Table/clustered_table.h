@@ -0,0 +1,46 @@
+#ifndef CLUSTERED_TABLE_H
+#define CLUSTERED_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "page_table.h"
+
+// A cluster covers this many consecutive virtual pages; its frames fill
+// exactly one cache line
+#define CLUSTER_PAGES 16
+#define CLUSTER_SHIFT 4
+
+// A superpage covers 2 MiB: this many 4 KiB pages mapped to consecutive
+// frames
+#define SUPERPAGE_PAGES 512
+#define SUPERPAGE_SHIFT 9
+
+// Clustered hash page table. The hash table maps a cluster number to a
+// block holding the frames of its pages and a bitmap of which of them are
+// mapped, so a dense range costs one hash entry per 16 pages. Superpages
+// map a whole aligned 2 MiB region with one entry in a second table.
+typedef struct {
+    HashPageTable* clusters;     // Cluster number -> block index
+    HashPageTable* superpages;   // Superpage number -> first frame
+    int* frames;                 // CLUSTER_PAGES frames per block, line aligned
+    unsigned short* valid;       // Bit i set if page i of the block is mapped
+    int num_blocks;
+    int block_capacity;
+    int* free_blocks;            // Blocks released by removals
+    int num_free;
+    int num_superpages;
+    int num_pages;               // Base pages mapped
+} ClusteredPageTable;
+
+ClusteredPageTable* init_clustered_table(void);
+bool clustered_insert(ClusteredPageTable* table, int virtual_page, int physical_frame);
+bool clustered_insert_superpage(ClusteredPageTable* table, int virtual_page, int first_frame);
+int clustered_lookup(ClusteredPageTable* table, int virtual_page);
+bool clustered_remove(ClusteredPageTable* table, int virtual_page);
+bool clustered_remove_superpage(ClusteredPageTable* table, int virtual_page);
+size_t clustered_table_bytes(const ClusteredPageTable* table);
+void print_clustered_stats(const ClusteredPageTable* table);
+void free_clustered_table(ClusteredPageTable* table);
+
+#endif
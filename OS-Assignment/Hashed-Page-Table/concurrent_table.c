@@ -0,0 +1,327 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "concurrent_table.h"
+
+// Epoch each reader thread entered its current lookup in, 0 when it is
+// not inside one. Shared by every concurrent table; a thread owns its
+// record from its first lookup until it exits.
+typedef struct {
+    unsigned long epoch;
+    int owned;
+    char pad[CACHE_LINE - sizeof(unsigned long) - sizeof(int)];
+} ReaderRecord;
+
+static ReaderRecord readers[MAX_READERS] __attribute__((aligned(CACHE_LINE)));
+static unsigned long global_epoch = 1;
+static __thread int reader_id = -1;
+static pthread_once_t reader_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t reader_key;
+
+static inline uint64_t make_slot(unsigned int key, int physical_frame) {
+    return ((uint64_t)key << 32) | (unsigned int)physical_frame;
+}
+
+static inline unsigned int slot_key(uint64_t slot) {
+    return (unsigned int)(slot >> 32);
+}
+
+static inline int slot_frame(uint64_t slot) {
+    return (int)(unsigned int)slot;
+}
+
+static inline int home_slot(const ConcurrentSlots* array, int virtual_page) {
+    return (int)(((unsigned int)virtual_page * 2654435769u) >> array->shift);
+}
+
+// Stripe guarding a page, independent of the array size
+static inline pthread_mutex_t* stripe_of(ConcurrentPageTable* table, int virtual_page) {
+    unsigned int hash = ((unsigned int)virtual_page * 2246822519u) >> 26;
+    return &table->stripes[hash % NUM_STRIPES].lock;
+}
+
+static ConcurrentSlots* alloc_concurrent_slots(int capacity) {
+    ConcurrentSlots* array = (ConcurrentSlots*)malloc(sizeof(ConcurrentSlots));
+    int bits = 0;
+    while ((1 << bits) < capacity) {
+        bits++;
+    }
+
+    array->capacity = capacity;
+    array->shift = 32 - bits;
+    array->next = NULL;
+    array->slots = (uint64_t*)aligned_alloc(CACHE_LINE, capacity * sizeof(uint64_t));
+    memset(array->slots, 0, capacity * sizeof(uint64_t));
+    return array;
+}
+
+static void free_concurrent_slots(ConcurrentSlots* array) {
+    free(array->slots);
+    free(array);
+}
+
+// Give a thread's reader record back when the thread exits
+static void release_reader(void* record) {
+    __atomic_store_n(&((ReaderRecord*)record)->owned, 0, __ATOMIC_RELEASE);
+}
+
+static void create_reader_key(void) {
+    pthread_key_create(&reader_key, release_reader);
+}
+
+// Claim a free reader record for this thread, or leave reader_id at -1 if
+// every record is owned
+static void claim_reader(void) {
+    pthread_once(&reader_key_once, create_reader_key);
+    for (int r = 0; r < MAX_READERS; r++) {
+        int owned = 0;
+        if (__atomic_load_n(&readers[r].owned, __ATOMIC_RELAXED) == 0 &&
+            __atomic_compare_exchange_n(&readers[r].owned, &owned, 1, false, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED)) {
+            pthread_setspecific(reader_key, &readers[r]);
+            reader_id = r;
+            return;
+        }
+    }
+}
+
+// Announce that this thread is reading. The store must be visible before
+// the table pointer is loaded, hence sequential consistency. A thread that
+// finds no free record holds retire_lock instead, so no array can be
+// retired, let alone freed, until its lookup is done.
+static void reader_enter(ConcurrentPageTable* table) {
+    if (reader_id < 0) {
+        claim_reader();
+    }
+    if (reader_id < 0) {
+        pthread_mutex_lock(&table->retire_lock);
+        return;
+    }
+    unsigned long epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&readers[reader_id].epoch, epoch, __ATOMIC_SEQ_CST);
+}
+
+static void reader_exit(ConcurrentPageTable* table) {
+    if (reader_id < 0) {
+        pthread_mutex_unlock(&table->retire_lock);
+        return;
+    }
+    __atomic_store_n(&readers[reader_id].epoch, 0, __ATOMIC_RELEASE);
+}
+
+// Free retired arrays that no reader can still be looking at: any reader
+// inside a lookup entered after the array was replaced
+static void reclaim_retired(ConcurrentPageTable* table) {
+    unsigned long oldest = (unsigned long)-1;
+
+    pthread_mutex_lock(&table->retire_lock);
+    for (int r = 0; r < MAX_READERS; r++) {
+        unsigned long epoch = __atomic_load_n(&readers[r].epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    ConcurrentSlots** link = &table->retired;
+    while (*link != NULL) {
+        ConcurrentSlots* array = *link;
+        if (array->retire_epoch < oldest) {
+            *link = array->next;
+            free_concurrent_slots(array);
+        } else {
+            link = &array->next;
+        }
+    }
+    pthread_mutex_unlock(&table->retire_lock);
+}
+
+ConcurrentPageTable* init_concurrent_table(void) {
+    ConcurrentPageTable* table = (ConcurrentPageTable*)aligned_alloc(CACHE_LINE,
+                                                                     sizeof(ConcurrentPageTable));
+    memset(table, 0, sizeof(ConcurrentPageTable));
+
+    table->current = alloc_concurrent_slots(TABLE_SIZE);
+    for (int i = 0; i < NUM_STRIPES; i++) {
+        pthread_mutex_init(&table->stripes[i].lock, NULL);
+    }
+    pthread_mutex_init(&table->retire_lock, NULL);
+
+    return table;
+}
+
+// Look up a page without taking any lock
+int concurrent_lookup(ConcurrentPageTable* table, int virtual_page) {
+    unsigned int key = page_key(virtual_page);
+    int physical_frame = INVALID_PAGE;
+
+    reader_enter(table);
+    ConcurrentSlots* array = __atomic_load_n(&table->current, __ATOMIC_SEQ_CST);
+    int mask = array->capacity - 1;
+
+    for (int index = home_slot(array, virtual_page);; index = (index + 1) & mask) {
+        uint64_t slot = __atomic_load_n(&array->slots[index], __ATOMIC_ACQUIRE);
+        // Empty first: EMPTY_SLOT has the key of an empty slot
+        if (slot_key(slot) == 0) {
+            break;
+        }
+        if (slot_key(slot) == key) {
+            physical_frame = slot_frame(slot);
+            break;
+        }
+    }
+    reader_exit(table);
+
+    return physical_frame;
+}
+
+// Rebuild into a fresh array, dropping removed pages and growing if the
+// live pages alone would crowd it. Every stripe is held, so no writer runs
+// while the copy is made; readers keep using the old array meanwhile.
+static void rebuild_table(ConcurrentPageTable* table) {
+    for (int i = 0; i < NUM_STRIPES; i++) {
+        pthread_mutex_lock(&table->stripes[i].lock);
+    }
+
+    // Another writer may have rebuilt while this one waited for the stripes
+    ConcurrentSlots* old = table->current;
+    if ((long)(table->used + 1) * 100 > (long)old->capacity * MAX_LOAD_PERCENT) {
+        int capacity = old->capacity;
+        while ((long)table->live * 200 > (long)capacity * MAX_LOAD_PERCENT) {
+            capacity *= 2;
+        }
+
+        ConcurrentSlots* array = alloc_concurrent_slots(capacity);
+        int mask = capacity - 1;
+        for (int i = 0; i < old->capacity; i++) {
+            uint64_t slot = old->slots[i];
+            if (slot_key(slot) == 0 || slot_frame(slot) == INVALID_PAGE) {
+                continue;
+            }
+            int index = home_slot(array, key_page(slot_key(slot)));
+            while (array->slots[index] != 0) {
+                index = (index + 1) & mask;
+            }
+            array->slots[index] = slot;
+        }
+
+        table->used = table->live;
+        __atomic_store_n(&table->current, array, __ATOMIC_SEQ_CST);
+
+        pthread_mutex_lock(&table->retire_lock);
+        old->retire_epoch = __atomic_fetch_add(&global_epoch, 1, __ATOMIC_SEQ_CST);
+        old->next = table->retired;
+        table->retired = old;
+        pthread_mutex_unlock(&table->retire_lock);
+    }
+
+    for (int i = NUM_STRIPES - 1; i >= 0; i--) {
+        pthread_mutex_unlock(&table->stripes[i].lock);
+    }
+    reclaim_retired(table);
+}
+
+// Map or remap a page
+bool concurrent_insert(ConcurrentPageTable* table, int virtual_page, int physical_frame) {
+    if (virtual_page == EMPTY_SLOT || physical_frame == INVALID_PAGE) {
+        printf("Warning: Virtual page %d cannot be mapped to frame %d\n", virtual_page,
+               physical_frame);
+        return false;
+    }
+
+    unsigned int key = page_key(virtual_page);
+    uint64_t entry = make_slot(key, physical_frame);
+    pthread_mutex_t* stripe = stripe_of(table, virtual_page);
+
+    for (;;) {
+        pthread_mutex_lock(stripe);
+        ConcurrentSlots* array = table->current;
+        int mask = array->capacity - 1;
+
+        // Reserve a slot up front, so writers on other stripes can never
+        // fill the array between the load check and the claim
+        long used = __atomic_add_fetch(&table->used, 1, __ATOMIC_RELAXED);
+        if (used * 100 > (long)array->capacity * MAX_LOAD_PERCENT) {
+            __atomic_sub_fetch(&table->used, 1, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(stripe);
+            rebuild_table(table);
+            continue;
+        }
+
+        // Only this thread can add or change this page, but other writers
+        // may claim empty slots along the way
+        for (int index = home_slot(array, virtual_page);; index = (index + 1) & mask) {
+            uint64_t slot = __atomic_load_n(&array->slots[index], __ATOMIC_ACQUIRE);
+
+            if (slot_key(slot) == key) {
+                __atomic_store_n(&array->slots[index], entry, __ATOMIC_RELEASE);
+                __atomic_sub_fetch(&table->used, 1, __ATOMIC_RELAXED);
+                if (slot_frame(slot) == INVALID_PAGE) {
+                    __atomic_add_fetch(&table->live, 1, __ATOMIC_RELAXED);
+                }
+                break;
+            }
+            if (slot == 0 && __atomic_compare_exchange_n(&array->slots[index], &slot, entry,
+                                                         false, __ATOMIC_RELEASE,
+                                                         __ATOMIC_ACQUIRE)) {
+                __atomic_add_fetch(&table->live, 1, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+
+        pthread_mutex_unlock(stripe);
+        return true;
+    }
+}
+
+// Unmap a page. Its slot keeps the key with an INVALID_PAGE frame until
+// the next rebuild, so probes for other pages still run past it.
+bool concurrent_remove(ConcurrentPageTable* table, int virtual_page) {
+    unsigned int key = page_key(virtual_page);
+    pthread_mutex_t* stripe = stripe_of(table, virtual_page);
+    bool removed = false;
+
+    pthread_mutex_lock(stripe);
+    ConcurrentSlots* array = table->current;
+    int mask = array->capacity - 1;
+
+    for (int index = home_slot(array, virtual_page);; index = (index + 1) & mask) {
+        uint64_t slot = __atomic_load_n(&array->slots[index], __ATOMIC_ACQUIRE);
+
+        if (slot_key(slot) == 0) {
+            break;
+        }
+        if (slot_key(slot) == key) {
+            if (slot_frame(slot) != INVALID_PAGE) {
+                __atomic_store_n(&array->slots[index], make_slot(key, INVALID_PAGE),
+                                 __ATOMIC_RELEASE);
+                __atomic_sub_fetch(&table->live, 1, __ATOMIC_RELAXED);
+                removed = true;
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(stripe);
+
+    return removed;
+}
+
+int concurrent_count(ConcurrentPageTable* table) {
+    return __atomic_load_n(&table->live, __ATOMIC_RELAXED);
+}
+
+// Free the table. No thread may be using it any more.
+void free_concurrent_table(ConcurrentPageTable* table) {
+    while (table->retired != NULL) {
+        ConcurrentSlots* next = table->retired->next;
+        free_concurrent_slots(table->retired);
+        table->retired = next;
+    }
+    free_concurrent_slots(table->current);
+
+    for (int i = 0; i < NUM_STRIPES; i++) {
+        pthread_mutex_destroy(&table->stripes[i].lock);
+    }
+    pthread_mutex_destroy(&table->retire_lock);
+    free(table);
+}
@@ -0,0 +1,55 @@
+#ifndef CONCURRENT_TABLE_H
+#define CONCURRENT_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "page_table.h"
+
+#define NUM_STRIPES 64
+#define MAX_READERS 256   // Reader records; threads beyond this take a lock
+
+// Slot array of a concurrent table. Each slot is one 64-bit word, the
+// page_key() of the virtual page in the high half and the frame in the low
+// half, so a reader always sees a whole entry. A key of 0 is an empty
+// slot; a key with frame INVALID_PAGE is a page that was removed.
+typedef struct ConcurrentSlots {
+    uint64_t* slots;
+    int capacity;                // Power of two
+    int shift;                   // 32 - log2(capacity)
+    unsigned long retire_epoch;
+    struct ConcurrentSlots* next; // Next retired array waiting to be freed
+} ConcurrentSlots;
+
+// Writer lock, padded so neighbouring stripes do not share a line
+typedef struct {
+    pthread_mutex_t lock;
+    char pad[CACHE_LINE - sizeof(pthread_mutex_t) % CACHE_LINE];
+} StripeLock;
+
+// Hash page table for many threads. Lookups take no lock and never wait:
+// they read the current slot array, found through one pointer, with plain
+// atomic loads. Writers lock the stripe of the page they change and claim
+// empty slots with compare-and-swap, so writers of different pages run in
+// parallel. Growing or purging removed pages takes every stripe and
+// publishes a new array; the old one is freed once no reader that could
+// still see it is inside a lookup (epoch-based reclamation).
+typedef struct {
+    ConcurrentSlots* current;
+    StripeLock stripes[NUM_STRIPES];
+    int used;                    // Slots holding a key, removed or not
+    int live;                    // Pages mapped
+
+    pthread_mutex_t retire_lock;
+    ConcurrentSlots* retired;
+} ConcurrentPageTable;
+
+ConcurrentPageTable* init_concurrent_table(void);
+int concurrent_lookup(ConcurrentPageTable* table, int virtual_page);
+bool concurrent_insert(ConcurrentPageTable* table, int virtual_page, int physical_frame);
+bool concurrent_remove(ConcurrentPageTable* table, int virtual_page);
+int concurrent_count(ConcurrentPageTable* table);
+void free_concurrent_table(ConcurrentPageTable* table);
+
+#endif
@@ -1,146 +1,29 @@
+// Demonstration of the hash page table and the TLB in front of it.
+// Build: gcc hashed_page.c page_table.c tlb.c clustered_table.c
+//            concurrent_table.c inverted_table.c -pthread
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 #include <stdbool.h>
+#include <pthread.h>
 
-#define TABLE_SIZE 16
-#define MAX_CHAIN 4
-#define PAGE_SIZE 4096
-#define INVALID_PAGE -1
+#include "page_table.h"
+#include "tlb.h"
+#include "clustered_table.h"
+#include "concurrent_table.h"
+#include "inverted_table.h"
 
-// Structure for page table entry
-typedef struct PageTableEntry {
-    int virtual_page;
-    int physical_frame;
-    bool valid;
-    struct PageTableEntry* next;
-} PageTableEntry;
+// Reader thread for the concurrent table demo: translate pages 0-4095
+// until the writer is done, counting the ones already mapped
+void* translate_pages(void* arg) {
+    ConcurrentPageTable* table = (ConcurrentPageTable*)arg;
+    long found = 0;
 
-// Structure for hash table
-typedef struct {
-    PageTableEntry* entries[TABLE_SIZE];
-    int num_pages;
-    int num_frames;
-    int collisions;
-} HashPageTable;
-
-// Hash function
-int hash_function(int virtual_page) {
-    return virtual_page % TABLE_SIZE;
-}
-
-// Initialize hash page table
-HashPageTable* init_page_table(int num_pages, int num_frames) {
-    HashPageTable* table = (HashPageTable*)malloc(sizeof(HashPageTable));
-    table->num_pages = num_pages;
-    table->num_frames = num_frames;
-    table->collisions = 0;
-    
-    for (int i = 0; i < TABLE_SIZE; i++) {
-        table->entries[i] = NULL;
-    }
-    
-    return table;
-}
-
-// Insert a page into the hash table
-bool insert_page(HashPageTable* table, int virtual_page, int physical_frame) {
-    int index = hash_function(virtual_page);
-    
-    // Create new entry
-    PageTableEntry* new_entry = (PageTableEntry*)malloc(sizeof(PageTableEntry));
-    new_entry->virtual_page = virtual_page;
-    new_entry->physical_frame = physical_frame;
-    new_entry->valid = true;
-    new_entry->next = NULL;
-    
-    // If slot is empty
-    if (table->entries[index] == NULL) {
-        table->entries[index] = new_entry;
-        return true;
-    }
-    
-    // Handle collision through chaining
-    PageTableEntry* current = table->entries[index];
-    int chain_length = 1;
-    
-    while (current->next != NULL) {
-        // Update existing entry if virtual page already exists
-        if (current->virtual_page == virtual_page) {
-            current->physical_frame = physical_frame;
-            current->valid = true;
-            free(new_entry);
-            return true;
+    for (int round = 0; round < 16; round++) {
+        for (int virtual_page = 0; virtual_page < 4096; virtual_page++) {
+            found += concurrent_lookup(table, virtual_page) != INVALID_PAGE;
         }
-        current = current->next;
-        chain_length++;
     }
-    
-    // Check if chain length exceeds maximum
-    if (chain_length >= MAX_CHAIN) {
-        printf("Warning: Maximum chain length exceeded at index %d\n", index);
-        free(new_entry);
-        return false;
-    }
-    
-    table->collisions++;
-    current->next = new_entry;
-    return true;
-}
-
-// Look up a page in the hash table
-int lookup_page(HashPageTable* table, int virtual_page) {
-    int index = hash_function(virtual_page);
-    PageTableEntry* current = table->entries[index];
-    
-    while (current != NULL) {
-        if (current->virtual_page == virtual_page && current->valid) {
-            return current->physical_frame;
-        }
-        current = current->next;
-    }
-    
-    return INVALID_PAGE;
-}
-
-// Print the current state of the page table
-void print_page_table(HashPageTable* table) {
-    printf("\nHash Page Table Status:\n");
-    printf("----------------------------------------\n");
-    
-    for (int i = 0; i < TABLE_SIZE; i++) {
-        printf("Index %2d: ", i);
-        PageTableEntry* current = table->entries[i];
-        
-        if (current == NULL) {
-            printf("Empty\n");
-            continue;
-        }
-        
-        while (current != NULL) {
-            printf("(VP: %d, PF: %d) -> ", 
-                   current->virtual_page, 
-                   current->physical_frame);
-            current = current->next;
-        }
-        printf("NULL\n");
-    }
-    
-    printf("----------------------------------------\n");
-    printf("Total collisions: %d\n", table->collisions);
-}
-
-// Free the page table memory
-void free_page_table(HashPageTable* table) {
-    for (int i = 0; i < TABLE_SIZE; i++) {
-        PageTableEntry* current = table->entries[i];
-        while (current != NULL) {
-            PageTableEntry* next = current->next;
-            free(current);
-            current = next;
-        }
-    }
-    free(table);
+    return (void*)found;
 }
 
 // Main function to demonstrate the hash page table
@@ -168,9 +51,11 @@ int main() {
     // Perform some lookups
     printf("\nPerforming page lookups:\n");
     int test_pages[] = {0, 5, 10, 15, 31};
+    int test_frames[5];
+    lookup_pages(table, test_pages, test_frames, 5);
     for (int i = 0; i < 5; i++) {
         int virtual_page = test_pages[i];
-        int physical_frame = lookup_page(table, virtual_page);
+        int physical_frame = test_frames[i];
         
         if (physical_frame != INVALID_PAGE) {
             printf("Found: Virtual Page %d -> Physical Frame %d\n", 
@@ -180,7 +65,86 @@ int main() {
         }
     }
     
+    // Counters gathered by the operations so far, then the same as JSON
+    print_page_table_stats(table);
+    write_page_table_stats(table, stdout);
+
+    // Save the table as an image and map it back: the copy answers lookups
+    // at once, without any inserts
+    if (save_page_table(table, "hashed_page.img")) {
+        HashPageTable* loaded = load_page_table("hashed_page.img");
+        if (loaded != NULL) {
+            printf("\nLoaded image: Virtual Page 10 -> Physical Frame %d\n",
+                   lookup_page(loaded, 10));
+            free_page_table(loaded);
+        }
+        remove("hashed_page.img");
+    }
+
+    // Translate a looping access pattern through a small TLB. Pages 0-5
+    // fit in it and hit after their first use; every tenth access goes to
+    // one of pages 6-19 and mostly misses.
+    Tlb* tlb = init_tlb(table, 8, 2, TLB_LRU, false);
+    for (int i = 0; i < 200; i++) {
+        tlb_translate(tlb, i % 10 == 9 ? 6 + i % 14 : (i * 7) % 6);
+    }
+    print_tlb_stats(tlb);
+
+    // Map a dense range of 8192 pages both ways and compare the memory
+    // each mapped page costs
+    HashPageTable* dense = init_page_table(8192, 8192);
+    ClusteredPageTable* clustered = init_clustered_table();
+    for (int i = 0; i < 8192; i++) {
+        insert_page(dense, 0x10000 + i, i);
+        clustered_insert(clustered, 0x10000 + i, i);
+    }
+    printf("\nDense range of 8192 pages:\n");
+    printf("Hash page table: %.2f bytes per page\n", (double)page_table_bytes(dense) / 8192);
+    print_clustered_stats(clustered);
+
+    // One 2 MiB superpage is a single entry
+    clustered_insert_superpage(clustered, 0x20000, 4096);
+    printf("After mapping a 2 MiB superpage at page %d:\n", 0x20000);
+    print_clustered_stats(clustered);
+    printf("Virtual Page %d -> Physical Frame %d\n", 0x20000 + 300,
+           clustered_lookup(clustered, 0x20000 + 300));
+
+    // Readers translate without locks while the main thread maps pages
+    ConcurrentPageTable* shared = init_concurrent_table();
+    pthread_t readers[4];
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&readers[i], NULL, translate_pages, shared);
+    }
+    for (int i = 0; i < 4096; i++) {
+        concurrent_insert(shared, i, i % table->num_frames);
+    }
+    printf("\nConcurrent table: %d pages mapped while 4 threads translated\n",
+           concurrent_count(shared));
+    for (int i = 0; i < 4; i++) {
+        void* found;
+        pthread_join(readers[i], &found);
+        printf("Reader %d saw %ld mapped translations\n", i, (long)found);
+    }
+
+    // Three processes share the physical frames through an inverted page
+    // table; the same virtual page of each gets its own frame
+    InvertedPageTable* inverted = init_inverted_table(table->num_frames);
+    for (int pid = 1; pid <= 3; pid++) {
+        for (int virtual_page = 0; virtual_page < 4; virtual_page++) {
+            ipt_map(inverted, pid, virtual_page);
+        }
+    }
+    printf("\nProcess 2, Virtual Page 3 -> Physical Frame %d\n", ipt_lookup(inverted, 2, 3));
+    print_inverted_stats(inverted);
+    printf("Flushed %d frames of process 2\n", ipt_flush_process(inverted, 2));
+    print_inverted_stats(inverted);
+
     // Clean up
+    free_inverted_table(inverted);
+    free_concurrent_table(shared);
+    free_clustered_table(clustered);
+    free_page_table(dense);
+    free_tlb(tlb);
     free_page_table(table);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "inverted_table.h"
+
+// Anchor of a (pid, virtual page) pair
+static inline int anchor_of(const InvertedPageTable* table, int pid, int virtual_page) {
+    unsigned int hash = ((unsigned int)pid * 2654435769u) ^ (unsigned int)virtual_page;
+    return (int)((hash * 2246822519u) >> table->anchor_shift);
+}
+
+InvertedPageTable* init_inverted_table(int num_frames) {
+    if (num_frames <= 0) {
+        return NULL;
+    }
+
+    // About two anchors per frame keeps chains short
+    int bits = 1;
+    while ((1 << bits) < 2 * num_frames) {
+        bits++;
+    }
+
+    InvertedPageTable* table = (InvertedPageTable*)malloc(sizeof(InvertedPageTable));
+    table->num_frames = num_frames;
+    table->entries = (InvertedEntry*)malloc(num_frames * sizeof(InvertedEntry));
+    table->process_next = (int*)malloc(num_frames * sizeof(int));
+    table->process_prev = (int*)malloc(num_frames * sizeof(int));
+    table->anchors = (int*)malloc((1 << bits) * sizeof(int));
+    table->anchor_shift = 32 - bits;
+    table->processes = init_page_table(0, num_frames);
+    table->num_mapped = 0;
+
+    for (int i = 0; i < (1 << bits); i++) {
+        table->anchors[i] = -1;
+    }
+
+    // Every frame starts on the free list, lowest number first
+    for (int frame = 0; frame < num_frames; frame++) {
+        table->entries[frame].pid = -1;
+        table->entries[frame].virtual_page = 0;
+        table->entries[frame].next = frame + 1 < num_frames ? frame + 1 : -1;
+    }
+    table->free_head = 0;
+
+    return table;
+}
+
+// Frame holding a page of a process, or INVALID_PAGE
+int ipt_lookup(const InvertedPageTable* table, int pid, int virtual_page) {
+    int frame = table->anchors[anchor_of(table, pid, virtual_page)];
+
+    while (frame != -1) {
+        const InvertedEntry* entry = &table->entries[frame];
+        if (entry->pid == pid && entry->virtual_page == virtual_page) {
+            return frame;
+        }
+        frame = entry->next;
+    }
+    return INVALID_PAGE;
+}
+
+// Give a page of a process a free frame and return it. A page that is
+// already mapped keeps its frame. Returns INVALID_PAGE when every frame is
+// in use; the caller has to unmap or flush something first.
+int ipt_map(InvertedPageTable* table, int pid, int virtual_page) {
+    if (pid < 0) {
+        printf("Warning: Process %d cannot map pages\n", pid);
+        return INVALID_PAGE;
+    }
+
+    int frame = ipt_lookup(table, pid, virtual_page);
+    if (frame != INVALID_PAGE) {
+        return frame;
+    }
+    if (table->free_head == -1) {
+        return INVALID_PAGE;
+    }
+
+    frame = table->free_head;
+    InvertedEntry* entry = &table->entries[frame];
+    table->free_head = entry->next;
+
+    int anchor = anchor_of(table, pid, virtual_page);
+    entry->pid = pid;
+    entry->virtual_page = virtual_page;
+    entry->next = table->anchors[anchor];
+    table->anchors[anchor] = frame;
+
+    // Push onto the front of the process's frame list
+    int head = lookup_page(table->processes, pid);
+    table->process_prev[frame] = -1;
+    table->process_next[frame] = head == INVALID_PAGE ? -1 : head;
+    if (head != INVALID_PAGE) {
+        table->process_prev[head] = frame;
+    }
+    insert_page(table->processes, pid, frame);
+
+    table->num_mapped++;
+    return frame;
+}
+
+// Take a mapped frame off its hash chain and process list and free it
+static void release_frame(InvertedPageTable* table, int frame) {
+    InvertedEntry* entry = &table->entries[frame];
+    int* link = &table->anchors[anchor_of(table, entry->pid, entry->virtual_page)];
+
+    while (*link != frame) {
+        link = &table->entries[*link].next;
+    }
+    *link = entry->next;
+
+    int prev = table->process_prev[frame];
+    int next = table->process_next[frame];
+    if (next != -1) {
+        table->process_prev[next] = prev;
+    }
+    if (prev != -1) {
+        table->process_next[prev] = next;
+    } else if (next != -1) {
+        insert_page(table->processes, entry->pid, next);
+    } else {
+        remove_page(table->processes, entry->pid);
+    }
+
+    entry->pid = -1;
+    entry->next = table->free_head;
+    table->free_head = frame;
+    table->num_mapped--;
+}
+
+bool ipt_unmap(InvertedPageTable* table, int pid, int virtual_page) {
+    int frame = ipt_lookup(table, pid, virtual_page);
+    if (frame == INVALID_PAGE) {
+        return false;
+    }
+    release_frame(table, frame);
+    return true;
+}
+
+// Unmap every page of a process. Returns how many frames were freed.
+int ipt_flush_process(InvertedPageTable* table, int pid) {
+    int freed = 0;
+    int frame;
+
+    while ((frame = lookup_page(table->processes, pid)) != INVALID_PAGE) {
+        release_frame(table, frame);
+        freed++;
+    }
+    return freed;
+}
+
+// Reverse translation: which page of which process a frame holds
+bool ipt_owner(const InvertedPageTable* table, int frame, int* pid, int* virtual_page) {
+    if (frame < 0 || frame >= table->num_frames || table->entries[frame].pid == -1) {
+        return false;
+    }
+    *pid = table->entries[frame].pid;
+    *virtual_page = table->entries[frame].virtual_page;
+    return true;
+}
+
+size_t inverted_table_bytes(const InvertedPageTable* table) {
+    size_t anchors = (size_t)1 << (32 - table->anchor_shift);
+    return sizeof(InvertedPageTable) + page_table_bytes(table->processes) +
+           (size_t)table->num_frames * (sizeof(InvertedEntry) + 2 * sizeof(int)) +
+           anchors * sizeof(int);
+}
+
+void print_inverted_stats(const InvertedPageTable* table) {
+    printf("\nInverted Page Table Status:\n");
+    printf("----------------------------------------\n");
+    printf("Frames: %d mapped, %d free\n", table->num_mapped,
+           table->num_frames - table->num_mapped);
+    printf("Processes with mapped pages: %d\n", page_count(table->processes));
+    printf("Memory: %zu bytes\n", inverted_table_bytes(table));
+}
+
+void free_inverted_table(InvertedPageTable* table) {
+    free_page_table(table->processes);
+    free(table->entries);
+    free(table->process_next);
+    free(table->process_prev);
+    free(table->anchors);
+    free(table);
+}
@@ -0,0 +1,45 @@
+#ifndef INVERTED_TABLE_H
+#define INVERTED_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "page_table.h"
+
+// Owner of a physical frame. next links frames whose (pid, virtual page)
+// hash to the same anchor; a free frame has pid -1 and next links the
+// free list.
+typedef struct {
+    int pid;
+    int virtual_page;
+    int next;
+} InvertedEntry;
+
+// Inverted page table: one entry per physical frame, found through a hash
+// anchor table keyed on (pid, virtual page). Its size depends only on the
+// number of frames, however many processes map however many pages. The
+// frames of each process are also on a doubly linked list, so a process
+// can be flushed without scanning the table.
+typedef struct {
+    InvertedEntry* entries;      // Indexed by frame number
+    int* process_next;           // Next frame of the same process, -1 at end
+    int* process_prev;
+    int num_frames;
+    int* anchors;                // First frame of each hash chain, -1 if none
+    int anchor_shift;            // 32 - log2(number of anchors)
+    HashPageTable* processes;    // pid -> first frame of its list
+    int free_head;
+    int num_mapped;
+} InvertedPageTable;
+
+InvertedPageTable* init_inverted_table(int num_frames);
+int ipt_lookup(const InvertedPageTable* table, int pid, int virtual_page);
+int ipt_map(InvertedPageTable* table, int pid, int virtual_page);
+bool ipt_unmap(InvertedPageTable* table, int pid, int virtual_page);
+int ipt_flush_process(InvertedPageTable* table, int pid);
+bool ipt_owner(const InvertedPageTable* table, int frame, int* pid, int* virtual_page);
+size_t inverted_table_bytes(const InvertedPageTable* table);
+void print_inverted_stats(const InvertedPageTable* table);
+void free_inverted_table(InvertedPageTable* table);
+
+#endif
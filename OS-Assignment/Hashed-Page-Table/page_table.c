@@ -0,0 +1,644 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "page_table.h"
+
+// Hash function (Fibonacci hashing, so strided page numbers still spread)
+int hash_function(const SlotArray* array, int virtual_page) {
+    return (int)(((unsigned int)virtual_page * 2654435769u) >> array->shift);
+}
+
+// Distance of the entry in a slot from its home slot
+static inline int probe_distance(const SlotArray* array, int index) {
+    int home = hash_function(array, key_page(array->slots[index].key));
+    return (index - home) & (array->capacity - 1);
+}
+
+// Bytes of mapped memory behind a slot array
+static size_t slot_bytes(int capacity) {
+    size_t bytes = (size_t)capacity * sizeof(PageTableEntry);
+    return (bytes + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+}
+
+// Use already mapped memory as a slot array
+static void init_slots_from(SlotArray* array, PageTableEntry* slots, int capacity) {
+    int bits = 0;
+    while ((1 << bits) < capacity) {
+        bits++;
+    }
+
+    array->capacity = capacity;
+    array->shift = 32 - bits;
+    array->count = 0;
+    array->slots = slots;
+}
+
+// Map an empty slot array. Anonymous memory is page and cache-line
+// aligned and reads as zero until written.
+static void init_slots(SlotArray* array, int capacity) {
+    void* slots = mmap(NULL, slot_bytes(capacity), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slots == MAP_FAILED) {
+        printf("Error: Cannot allocate %d page table slots\n", capacity);
+        exit(1);
+    }
+    init_slots_from(array, (PageTableEntry*)slots, capacity);
+}
+
+// Unmap part of the retired slot memory
+static void release_retired(HashPageTable* table, size_t max_bytes) {
+    size_t bytes = table->retired_bytes < max_bytes ? table->retired_bytes : max_bytes;
+    if (bytes == 0) {
+        return;
+    }
+
+    table->retired_bytes -= bytes;
+    munmap(table->retired + table->retired_bytes, bytes);
+}
+
+// Place an entry that is known not to be in the array yet. Returns true if
+// its home slot was taken.
+static bool place_entry(SlotArray* array, PageTableEntry entry) {
+    int mask = array->capacity - 1;
+    int index = hash_function(array, key_page(entry.key));
+    int distance = 0;
+    bool collided = array->slots[index].key != 0;
+
+    while (array->slots[index].key != 0) {
+        // Take the slot from an entry that is closer to its home
+        int resident = probe_distance(array, index);
+        if (resident < distance) {
+            PageTableEntry displaced = array->slots[index];
+            array->slots[index] = entry;
+            entry = displaced;
+            distance = resident;
+        }
+        index = (index + 1) & mask;
+        distance++;
+    }
+
+    array->slots[index] = entry;
+    array->count++;
+    return collided;
+}
+
+// Find the slot holding a virtual page, starting from its home slot, or -1.
+// probes receives the number of slots examined.
+static inline int find_slot_from(const SlotArray* array, int virtual_page, int index,
+                                 int* probes) {
+    int mask = array->capacity - 1;
+    unsigned int key = page_key(virtual_page);
+
+    for (int distance = 0;; distance++) {
+        unsigned int resident = array->slots[index].key;
+        // Empty first: EMPTY_SLOT has the key of an empty slot
+        if (resident == 0) {
+            *probes = distance + 1;
+            return -1;
+        }
+        if (resident == key) {
+            *probes = distance + 1;
+            return index;
+        }
+        // Past every entry that could share this home slot
+        if (probe_distance(array, index) < distance) {
+            *probes = distance + 1;
+            return -1;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+// Find the slot holding a virtual page, or -1
+static int find_slot(const SlotArray* array, int virtual_page) {
+    int probes;
+    return find_slot_from(array, virtual_page, hash_function(array, virtual_page), &probes);
+}
+
+// Cycle counter for latency samples; nanoseconds where there is no TSC
+static inline unsigned long long read_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+// Whether to time this operation: one in every STATS_SAMPLE_INTERVAL
+static inline bool sample_now(PageTableStats* stats) {
+    if (--stats->sample_countdown > 0) {
+        return false;
+    }
+    stats->sample_countdown = STATS_SAMPLE_INTERVAL;
+    return true;
+}
+
+// Add a latency sample to a power-of-two histogram
+static void record_cycles(long long histogram[], unsigned long long cycles) {
+    int bucket = 0;
+    while (cycles > 1 && bucket < LATENCY_BUCKETS - 1) {
+        cycles >>= 1;
+        bucket++;
+    }
+    histogram[bucket]++;
+}
+
+static inline void record_lookup(PageTableStats* stats, int probes, bool hit) {
+    stats->lookups++;
+    stats->hits += hit;
+    stats->probe_histogram[probes < PROBE_BUCKETS ? probes - 1 : PROBE_BUCKETS - 1]++;
+    if (probes > stats->max_probe) {
+        stats->max_probe = probes;
+    }
+}
+
+// Remove the entry in a slot, shifting the entries after it back a slot
+// until one is already at home
+static void erase_slot(SlotArray* array, int index) {
+    int mask = array->capacity - 1;
+    int next = (index + 1) & mask;
+
+    while (array->slots[next].key != 0 && probe_distance(array, next) > 0) {
+        array->slots[index] = array->slots[next];
+        index = next;
+        next = (next + 1) & mask;
+    }
+
+    array->slots[index].key = 0;
+    array->slots[index].physical_frame = 0;
+    array->count--;
+}
+
+// Slot of a virtual page in the part of the old array not yet moved, or -1
+static int find_unmigrated(const HashPageTable* table, int virtual_page) {
+    if (!table->migrating) {
+        return -1;
+    }
+    int index = find_slot(&table->old, virtual_page);
+    return index >= table->migrate_cursor ? index : -1;
+}
+
+// Move up to max_slots old slots into the current array
+static void migrate_step(HashPageTable* table, int max_slots) {
+    if (!table->migrating) {
+        release_retired(table, RELEASE_BYTES);
+        return;
+    }
+
+    int stop = table->migrate_cursor + max_slots;
+    if (stop > table->old.capacity || max_slots < 0) {
+        stop = table->old.capacity;
+    }
+
+    for (int i = table->migrate_cursor; i < stop; i++) {
+        PageTableEntry entry = table->old.slots[i];
+        if (entry.key != 0 && entry.physical_frame != INVALID_PAGE) {
+            place_entry(&table->current, entry);
+            table->old_live--;
+        }
+    }
+    table->migrate_cursor = stop;
+
+    if (stop == table->old.capacity) {
+        table->retired = (char*)table->old.slots;
+        table->retired_bytes = slot_bytes(table->old.capacity);
+        table->old.slots = NULL;
+        table->migrating = false;
+    }
+}
+
+// Number of pages mapped
+int page_count(const HashPageTable* table) {
+    return table->current.count + (table->migrating ? table->old_live : 0);
+}
+
+// Bytes of memory the table holds, including an array being drained
+size_t page_table_bytes(const HashPageTable* table) {
+    size_t bytes = sizeof(HashPageTable) + slot_bytes(table->current.capacity);
+    if (table->migrating) {
+        bytes += slot_bytes(table->old.capacity);
+    }
+    return bytes + table->retired_bytes;
+}
+
+// Start moving the table into a slot array of the given capacity. A
+// migration still in progress is finished first.
+static void start_resize(HashPageTable* table, int capacity) {
+    migrate_step(table, -1);
+    release_retired(table, table->retired_bytes);
+
+    table->old = table->current;
+    table->old_live = table->old.count;
+    table->migrate_cursor = 0;
+    table->migrating = true;
+    init_slots(&table->current, capacity);
+}
+
+// Grow or shrink when the load leaves its band. The new array is sized so
+// that the migration finishes well before it fills up.
+static void check_load(HashPageTable* table) {
+    long count = page_count(table);
+    long capacity = table->current.capacity;
+
+    if ((count + 1) * 100 > capacity * MAX_LOAD_PERCENT) {
+        start_resize(table, table->current.capacity * 2);
+    } else if (!table->migrating && capacity > TABLE_SIZE &&
+               count * 100 < capacity * MIN_LOAD_PERCENT) {
+        start_resize(table, table->current.capacity / 2);
+    }
+}
+
+// Initialize hash page table
+HashPageTable* init_page_table(int num_pages, int num_frames) {
+    HashPageTable* table = (HashPageTable*)malloc(sizeof(HashPageTable));
+    table->num_pages = num_pages;
+    table->num_frames = num_frames;
+    table->collisions = 0;
+    table->migrating = false;
+    table->migrate_cursor = 0;
+    table->old_live = 0;
+    table->old.slots = NULL;
+    table->retired = NULL;
+    table->retired_bytes = 0;
+    memset(&table->stats, 0, sizeof(PageTableStats));
+    table->stats.sample_countdown = STATS_SAMPLE_INTERVAL;
+
+    init_slots(&table->current, TABLE_SIZE);
+
+    return table;
+}
+
+// Insert a page into the hash table. The table grows as needed, so this
+// only fails for a page number it cannot store.
+bool insert_page(HashPageTable* table, int virtual_page, int physical_frame) {
+    if (virtual_page == EMPTY_SLOT || physical_frame == INVALID_PAGE) {
+        printf("Warning: Virtual page %d cannot be mapped to frame %d\n", virtual_page,
+               physical_frame);
+        return false;
+    }
+
+    bool sampled = sample_now(&table->stats);
+    unsigned long long start = sampled ? read_cycles() : 0;
+
+    migrate_step(table, MIGRATE_SLOTS);
+    table->stats.inserts++;
+
+    // Update existing entry if virtual page already exists
+    int index = find_slot(&table->current, virtual_page);
+    if (index >= 0) {
+        table->current.slots[index].physical_frame = physical_frame;
+        table->stats.updates++;
+    } else if ((index = find_unmigrated(table, virtual_page)) >= 0 &&
+               table->old.slots[index].physical_frame != INVALID_PAGE) {
+        table->old.slots[index].physical_frame = physical_frame;
+        table->stats.updates++;
+    } else {
+        check_load(table);
+
+        PageTableEntry entry = {page_key(virtual_page), physical_frame};
+        if (place_entry(&table->current, entry)) {
+            table->collisions++;
+        }
+    }
+
+    if (sampled) {
+        record_cycles(table->stats.insert_cycles, read_cycles() - start);
+    }
+    return true;
+}
+
+// Look up a page in the hash table
+int lookup_page(HashPageTable* table, int virtual_page) {
+    bool sampled = sample_now(&table->stats);
+    unsigned long long start = sampled ? read_cycles() : 0;
+    const SlotArray* array = &table->current;
+    int physical_frame = INVALID_PAGE;
+    int probes;
+
+    migrate_step(table, MIGRATE_SLOTS);
+
+    int index = find_slot_from(array, virtual_page, hash_function(array, virtual_page), &probes);
+    if (index >= 0) {
+        physical_frame = array->slots[index].physical_frame;
+    } else if ((index = find_unmigrated(table, virtual_page)) >= 0) {
+        physical_frame = table->old.slots[index].physical_frame;
+    }
+    record_lookup(&table->stats, probes, physical_frame != INVALID_PAGE);
+
+    if (sampled) {
+        record_cycles(table->stats.lookup_cycles, read_cycles() - start);
+    }
+    return physical_frame;
+}
+
+// Look up many pages at once. Each group of pages is hashed and has its
+// home lines prefetched before any of them is probed, so the cache misses
+// of a whole group overlap instead of being taken one after another.
+void lookup_pages(HashPageTable* table, const int virtual_pages[], int frames[], int count) {
+    int homes[LOOKUP_GROUP];
+
+    for (int start = 0; start < count; start += LOOKUP_GROUP) {
+        int size = count - start < LOOKUP_GROUP ? count - start : LOOKUP_GROUP;
+        const int* pages = virtual_pages + start;
+
+        migrate_step(table, MIGRATE_SLOTS * size);
+        const SlotArray* array = &table->current;
+
+        for (int i = 0; i < size; i++) {
+            homes[i] = hash_function(array, pages[i]);
+            __builtin_prefetch(&array->slots[homes[i]], 0, 1);
+        }
+
+        for (int i = 0; i < size; i++) {
+            int probes;
+            int index = find_slot_from(array, pages[i], homes[i], &probes);
+            if (index >= 0) {
+                frames[start + i] = array->slots[index].physical_frame;
+            } else {
+                index = find_unmigrated(table, pages[i]);
+                frames[start + i] = index >= 0 ? table->old.slots[index].physical_frame
+                                               : INVALID_PAGE;
+            }
+            record_lookup(&table->stats, probes, frames[start + i] != INVALID_PAGE);
+        }
+    }
+}
+
+// Translate virtual addresses to frames, INVALID_PAGE where unmapped
+void translate_addresses(HashPageTable* table, const unsigned long addresses[], int frames[],
+                         int count) {
+    int pages[LOOKUP_GROUP];
+
+    for (int start = 0; start < count; start += LOOKUP_GROUP) {
+        int size = count - start < LOOKUP_GROUP ? count - start : LOOKUP_GROUP;
+        for (int i = 0; i < size; i++) {
+            pages[i] = (int)(addresses[start + i] / PAGE_SIZE);
+        }
+        lookup_pages(table, pages, frames + start, size);
+    }
+}
+
+// Remove a page from the hash table. Returns false if it was not mapped.
+bool remove_page(HashPageTable* table, int virtual_page) {
+    bool removed = false;
+
+    migrate_step(table, MIGRATE_SLOTS);
+
+    int index = find_slot(&table->current, virtual_page);
+    if (index >= 0) {
+        erase_slot(&table->current, index);
+        removed = true;
+    }
+    index = find_unmigrated(table, virtual_page);
+    if (index >= 0 && table->old.slots[index].physical_frame != INVALID_PAGE) {
+        table->old.slots[index].physical_frame = INVALID_PAGE;
+        table->old_live--;
+        removed = true;
+    }
+
+    if (removed) {
+        table->stats.removes++;
+        check_load(table);
+    }
+    return removed;
+}
+
+// Print the current state of the page table, one cache line per row
+void print_page_table(HashPageTable* table) {
+    const SlotArray* array = &table->current;
+
+    printf("\nHash Page Table Status:\n");
+    printf("----------------------------------------\n");
+
+    // Large tables get only the summary
+    int num_lines = array->capacity / SLOTS_PER_LINE;
+    if (num_lines > PRINT_MAX_LINES) {
+        printf("(%d cache lines not shown)\n", num_lines);
+        num_lines = 0;
+    }
+
+    for (int line = 0; line < num_lines; line++) {
+        printf("Line %2d: ", line);
+        bool empty = true;
+
+        for (int i = line * SLOTS_PER_LINE; i < (line + 1) * SLOTS_PER_LINE; i++) {
+            if (array->slots[i].key == 0) {
+                continue;
+            }
+            printf("(VP: %d, PF: %d) ",
+                   key_page(array->slots[i].key),
+                   array->slots[i].physical_frame);
+            empty = false;
+        }
+        printf(empty ? "Empty\n" : "\n");
+    }
+
+    printf("----------------------------------------\n");
+    if (table->migrating) {
+        printf("Resizing from %d slots: %d moved, %d entries left to move\n",
+               table->old.capacity, table->migrate_cursor, table->old_live);
+    }
+    printf("Entries: %d, slots: %d, load factor: %.2f\n", page_count(table), array->capacity,
+           (double)page_count(table) / array->capacity);
+    printf("Total collisions: %d\n", table->collisions);
+}
+
+// Approximate percentile of a power-of-two latency histogram: the upper
+// bound of the bucket it falls in
+static unsigned long long histogram_percentile(const long long histogram[], int percent) {
+    long long total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        total += histogram[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    long long seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen * 100 >= total * percent) {
+            return 1ULL << (i + 1);
+        }
+    }
+    return 1ULL << LATENCY_BUCKETS;
+}
+
+static void print_latency(const char* name, const long long histogram[]) {
+    if (histogram_percentile(histogram, 100) == 0) {
+        printf("%s cycles (sampled): no samples yet\n", name);
+        return;
+    }
+    printf("%s cycles (sampled): p50 <%llu, p99 <%llu\n", name,
+           histogram_percentile(histogram, 50), histogram_percentile(histogram, 99));
+}
+
+// Print the counters and histograms, without dumping the slots
+void print_page_table_stats(const HashPageTable* table) {
+    const PageTableStats* stats = &table->stats;
+
+    printf("\nHash Page Table Statistics:\n");
+    printf("----------------------------------------\n");
+    printf("Entries: %d, slots: %d, load factor: %.2f%s\n", page_count(table),
+           table->current.capacity, (double)page_count(table) / table->current.capacity,
+           table->migrating ? " (resizing)" : "");
+    printf("Lookups: %lld, hits: %lld, misses: %lld\n", stats->lookups, stats->hits,
+           stats->lookups - stats->hits);
+    printf("Inserts: %lld (%lld updates), removes: %lld\n", stats->inserts, stats->updates,
+           stats->removes);
+    printf("Probe lengths:");
+    for (int i = 0; i < PROBE_BUCKETS; i++) {
+        if (stats->probe_histogram[i] > 0) {
+            printf(" %d%s:%lld", i + 1, i == PROBE_BUCKETS - 1 ? "+" : "",
+                   stats->probe_histogram[i]);
+        }
+    }
+    printf(" (max %d)\n", stats->max_probe);
+    print_latency("Lookup", stats->lookup_cycles);
+    print_latency("Insert", stats->insert_cycles);
+}
+
+static void write_histogram(FILE* out, const char* name, const long long histogram[], int size) {
+    fprintf(out, "  \"%s\": [", name);
+    for (int i = 0; i < size; i++) {
+        fprintf(out, "%s%lld", i ? ", " : "", histogram[i]);
+    }
+    fprintf(out, "]");
+}
+
+// Write a JSON snapshot of the statistics. Probe histogram entry i counts
+// lookups that examined i + 1 slots (the last entry: that many or more);
+// latency histogram entry i counts samples of [2^i, 2^(i+1)) cycles.
+void write_page_table_stats(const HashPageTable* table, FILE* out) {
+    const PageTableStats* stats = &table->stats;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"entries\": %d,\n  \"slots\": %d,\n  \"load_factor\": %.4f,\n",
+            page_count(table), table->current.capacity,
+            (double)page_count(table) / table->current.capacity);
+    fprintf(out, "  \"resizing\": %s,\n  \"bytes\": %zu,\n", table->migrating ? "true" : "false",
+            page_table_bytes(table));
+    fprintf(out, "  \"lookups\": %lld,\n  \"hits\": %lld,\n  \"misses\": %lld,\n",
+            stats->lookups, stats->hits, stats->lookups - stats->hits);
+    fprintf(out, "  \"inserts\": %lld,\n  \"updates\": %lld,\n  \"removes\": %lld,\n",
+            stats->inserts, stats->updates, stats->removes);
+    fprintf(out, "  \"collisions\": %d,\n  \"max_probe\": %d,\n", table->collisions,
+            stats->max_probe);
+    fprintf(out, "  \"sample_interval\": %d,\n", STATS_SAMPLE_INTERVAL);
+    write_histogram(out, "probe_histogram", stats->probe_histogram, PROBE_BUCKETS);
+    fprintf(out, ",\n");
+    write_histogram(out, "lookup_cycles", stats->lookup_cycles, LATENCY_BUCKETS);
+    fprintf(out, ",\n");
+    write_histogram(out, "insert_cycles", stats->insert_cycles, LATENCY_BUCKETS);
+    fprintf(out, "\n}\n");
+}
+
+void reset_page_table_stats(HashPageTable* table) {
+    memset(&table->stats, 0, sizeof(PageTableStats));
+    table->stats.sample_countdown = STATS_SAMPLE_INTERVAL;
+}
+
+// Free the page table memory
+void free_page_table(HashPageTable* table) {
+    munmap(table->current.slots, slot_bytes(table->current.capacity));
+    if (table->old.slots != NULL) {
+        munmap(table->old.slots, slot_bytes(table->old.capacity));
+    }
+    release_retired(table, table->retired_bytes);
+    free(table);
+}
+
+// Write the table as a flat file image: an IMAGE_HEADER_BYTES header, then
+// the slot array exactly as it sits in memory. Slots hold no pointers, so
+// the image can be mapped at any address. A resize in progress is
+// finished first.
+bool save_page_table(HashPageTable* table, const char* path) {
+    migrate_step(table, -1);
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Error: Cannot write page table image %s\n", path);
+        return false;
+    }
+
+    char* header = (char*)calloc(1, IMAGE_HEADER_BYTES);
+    PageTableImage* image = (PageTableImage*)header;
+    memcpy(image->magic, IMAGE_MAGIC, sizeof(image->magic));
+    image->version = IMAGE_VERSION;
+    image->byte_order = IMAGE_BYTE_ORDER;
+    image->entry_size = sizeof(PageTableEntry);
+    image->capacity = table->current.capacity;
+    image->count = table->current.count;
+    image->num_pages = table->num_pages;
+    image->num_frames = table->num_frames;
+    image->collisions = table->collisions;
+
+    size_t bytes = slot_bytes(table->current.capacity);
+    bool ok = fwrite(header, IMAGE_HEADER_BYTES, 1, file) == 1 &&
+              fwrite(table->current.slots, bytes, 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    free(header);
+
+    if (!ok) {
+        printf("Error: Cannot write page table image %s\n", path);
+    }
+    return ok;
+}
+
+// Map a saved image and use it as the table's slot array, without reading
+// or rehashing the entries. The mapping is private: lookups share the
+// file's pages with the page cache, and the first insert or remove that
+// touches a page gets a private copy of it. The file itself never
+// changes.
+HashPageTable* load_page_table(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open page table image %s\n", path);
+        return NULL;
+    }
+
+    PageTableImage image;
+    struct stat info;
+    bool valid = pread(fd, &image, sizeof(image), 0) == (ssize_t)sizeof(image) &&
+                 fstat(fd, &info) == 0 &&
+                 memcmp(image.magic, IMAGE_MAGIC, sizeof(image.magic)) == 0 &&
+                 image.version == IMAGE_VERSION && image.byte_order == IMAGE_BYTE_ORDER &&
+                 image.entry_size == sizeof(PageTableEntry) && image.capacity >= TABLE_SIZE &&
+                 (image.capacity & (image.capacity - 1)) == 0 &&
+                 image.count >= 0 && image.count < image.capacity &&
+                 (size_t)info.st_size >= IMAGE_HEADER_BYTES + slot_bytes(image.capacity);
+    if (!valid) {
+        printf("Error: %s is not a page table image\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    PageTableEntry* slots = (PageTableEntry*)mmap(NULL, slot_bytes(image.capacity),
+                                                  PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                                                  IMAGE_HEADER_BYTES);
+    close(fd);
+    if (slots == MAP_FAILED) {
+        printf("Error: Cannot map page table image %s\n", path);
+        return NULL;
+    }
+
+    HashPageTable* table = init_page_table(image.num_pages, image.num_frames);
+    munmap(table->current.slots, slot_bytes(table->current.capacity));
+    init_slots_from(&table->current, slots, image.capacity);
+    table->current.count = image.count;
+    table->collisions = image.collisions;
+
+    return table;
+}
@@ -0,0 +1,129 @@
+#ifndef PAGE_TABLE_H
+#define PAGE_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+#include <stdio.h>
+
+#define TABLE_SIZE 16
+#define PAGE_SIZE 4096
+#define INVALID_PAGE -1
+#define CACHE_LINE 64
+#define SLOTS_PER_LINE (CACHE_LINE / (int)sizeof(PageTableEntry))
+#define MAX_LOAD_PERCENT 85
+#define MIN_LOAD_PERCENT 20
+#define MIGRATE_SLOTS 16
+#define RELEASE_BYTES (256 * 1024)
+#define LOOKUP_GROUP 16
+#define PROBE_BUCKETS 17
+#define LATENCY_BUCKETS 32
+#define STATS_SAMPLE_INTERVAL 64
+#define PRINT_MAX_LINES 64
+
+// Saved table images. The header takes a whole 64 KiB so the slots that
+// follow it can be mapped straight from the file on any page size.
+#define IMAGE_MAGIC "HPTIMAGE"
+#define IMAGE_VERSION 1
+#define IMAGE_BYTE_ORDER 0x01020304u
+#define IMAGE_HEADER_BYTES 65536
+#define EMPTY_SLOT INT_MIN
+
+// Structure for page table entry. Eight of them share a cache line. The
+// key is the virtual page with its top bit flipped, so that zeroed memory
+// is a run of empty slots and EMPTY_SLOT is the one page that cannot be
+// mapped.
+typedef struct {
+    unsigned int key;
+    int physical_frame;
+} PageTableEntry;
+
+static inline unsigned int page_key(int virtual_page) {
+    return (unsigned int)virtual_page ^ 0x80000000u;
+}
+
+static inline int key_page(unsigned int key) {
+    return (int)(key ^ 0x80000000u);
+}
+
+// Open-addressed slot array with Robin Hood probing. Every entry sits a
+// short distance after its home slot, and entries further from home are
+// kept ahead of closer ones, so a lookup scans one or two cache lines.
+typedef struct {
+    PageTableEntry* slots;   // capacity entries, cache-line aligned
+    int capacity;            // Power of two
+    int shift;               // 32 - log2(capacity)
+    int count;
+} SlotArray;
+
+// Counters kept on every operation, cheap enough to leave on. Lookup
+// probe lengths go in probe_histogram (the last bucket takes everything
+// longer); one operation in STATS_SAMPLE_INTERVAL is timed, and its cycle
+// count goes in a power-of-two histogram.
+typedef struct {
+    long long lookups;
+    long long hits;
+    long long inserts;
+    long long updates;
+    long long removes;
+    long long probe_histogram[PROBE_BUCKETS];
+    int max_probe;
+    int sample_countdown;
+    long long lookup_cycles[LATENCY_BUCKETS];
+    long long insert_cycles[LATENCY_BUCKETS];
+} PageTableStats;
+
+// Hash page table. A resize does not rehash everything at once: the old
+// slot array stays in place while each operation moves the next
+// MIGRATE_SLOTS of its slots into the new one. Old slots before
+// migrate_cursor have been moved; a removed entry that has not been moved
+// yet keeps its slot with physical_frame set to INVALID_PAGE. Slot memory
+// comes zeroed from the kernel a page at a time, and a drained array is
+// handed back RELEASE_BYTES per operation, so neither end of a resize
+// touches the whole array at once.
+typedef struct {
+    SlotArray current;
+    SlotArray old;
+    bool migrating;
+    int migrate_cursor;
+    int old_live;            // Old entries still to be moved
+    char* retired;           // Drained slot memory not yet unmapped
+    size_t retired_bytes;
+    int num_pages;
+    int num_frames;
+    int collisions;          // Inserts whose home slot was taken
+    PageTableStats stats;
+} HashPageTable;
+
+// Header at the start of a saved image
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int byte_order;     // IMAGE_BYTE_ORDER as the writer stored it
+    unsigned int entry_size;
+    int capacity;
+    int count;
+    int num_pages;
+    int num_frames;
+    int collisions;
+} PageTableImage;
+
+int hash_function(const SlotArray* array, int virtual_page);
+HashPageTable* init_page_table(int num_pages, int num_frames);
+bool insert_page(HashPageTable* table, int virtual_page, int physical_frame);
+int lookup_page(HashPageTable* table, int virtual_page);
+void lookup_pages(HashPageTable* table, const int virtual_pages[], int frames[], int count);
+void translate_addresses(HashPageTable* table, const unsigned long addresses[], int frames[],
+                         int count);
+bool remove_page(HashPageTable* table, int virtual_page);
+int page_count(const HashPageTable* table);
+size_t page_table_bytes(const HashPageTable* table);
+void print_page_table(HashPageTable* table);
+void print_page_table_stats(const HashPageTable* table);
+void write_page_table_stats(const HashPageTable* table, FILE* out);
+void reset_page_table_stats(HashPageTable* table);
+void free_page_table(HashPageTable* table);
+bool save_page_table(HashPageTable* table, const char* path);
+HashPageTable* load_page_table(const char* path);
+
+#endif
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tlb.h"
+
+Tlb* init_tlb(HashPageTable* table, int num_entries, int ways, TlbPolicy policy, bool use_asid) {
+    if (ways <= 0 || num_entries <= 0 || num_entries % ways != 0) {
+        return NULL;
+    }
+
+    int num_sets = num_entries / ways;
+    if ((num_sets & (num_sets - 1)) != 0) {
+        return NULL;
+    }
+
+    Tlb* tlb = (Tlb*)calloc(1, sizeof(Tlb));
+    tlb->entries = (TlbEntry*)calloc(num_entries, sizeof(TlbEntry));
+    tlb->num_sets = num_sets;
+    tlb->ways = ways;
+    tlb->policy = policy;
+    tlb->use_asid = use_asid;
+    tlb->table = table;
+    tlb->random_state = 2463534242u;
+    tlb->hit_cycles = TLB_HIT_CYCLES;
+    tlb->miss_cycles = TLB_MISS_CYCLES;
+
+    return tlb;
+}
+
+// First entry of the set a virtual page maps to
+static TlbEntry* tlb_set(const Tlb* tlb, int virtual_page) {
+    int set = (int)((unsigned int)virtual_page & (unsigned int)(tlb->num_sets - 1));
+    return tlb->entries + (size_t)set * tlb->ways;
+}
+
+// Way to refill in a full or partly empty set
+static TlbEntry* choose_victim(Tlb* tlb, TlbEntry* set) {
+    TlbEntry* victim = &set[0];
+
+    for (int way = 0; way < tlb->ways; way++) {
+        if (set[way].key == 0) {
+            return &set[way];
+        }
+    }
+
+    if (tlb->policy == TLB_RANDOM) {
+        tlb->random_state ^= tlb->random_state << 13;
+        tlb->random_state ^= tlb->random_state >> 17;
+        tlb->random_state ^= tlb->random_state << 5;
+        return &set[tlb->random_state % (unsigned int)tlb->ways];
+    }
+
+    // LRU and FIFO both evict the oldest stamp; they differ in whether a
+    // hit refreshes it
+    for (int way = 1; way < tlb->ways; way++) {
+        if (set[way].stamp - tlb->clock < victim->stamp - tlb->clock) {
+            victim = &set[way];
+        }
+    }
+    return victim;
+}
+
+// Translate a virtual page of the current address space. Hits never touch
+// the page table; misses look the page up and cache the result.
+int tlb_translate(Tlb* tlb, int virtual_page) {
+    unsigned int key = page_key(virtual_page);
+    TlbEntry* set = tlb_set(tlb, virtual_page);
+
+    // EMPTY_SLOT has the key of an empty entry and is never mapped, so it
+    // skips the search and misses
+    tlb->clock++;
+    for (int way = 0; way < tlb->ways && virtual_page != EMPTY_SLOT; way++) {
+        if (set[way].key == key && set[way].asid == tlb->asid) {
+            if (tlb->policy == TLB_LRU) {
+                set[way].stamp = tlb->clock;
+            }
+            tlb->hits++;
+            tlb->cycles += tlb->hit_cycles;
+            return set[way].physical_frame;
+        }
+    }
+
+    tlb->misses++;
+    tlb->cycles += tlb->hit_cycles + tlb->miss_cycles;
+
+    int physical_frame = lookup_page(tlb->table, virtual_page);
+    if (physical_frame == INVALID_PAGE) {
+        tlb->faults++;
+        return INVALID_PAGE;
+    }
+
+    TlbEntry* victim = choose_victim(tlb, set);
+    victim->key = key;
+    victim->asid = tlb->asid;
+    victim->physical_frame = physical_frame;
+    victim->stamp = tlb->clock;
+    return physical_frame;
+}
+
+// Switch to another address space and its page table
+void tlb_switch(Tlb* tlb, int asid, HashPageTable* table) {
+    if (!tlb->use_asid) {
+        tlb_flush(tlb);
+        asid = 0;
+    }
+    tlb->asid = asid;
+    tlb->table = table;
+}
+
+// Drop a cached translation of the current address space. Call this after
+// remapping or removing the page in the page table.
+void tlb_invalidate(Tlb* tlb, int virtual_page) {
+    unsigned int key = page_key(virtual_page);
+    TlbEntry* set = tlb_set(tlb, virtual_page);
+
+    for (int way = 0; way < tlb->ways; way++) {
+        if (set[way].key == key && set[way].asid == tlb->asid) {
+            set[way].key = 0;
+        }
+    }
+}
+
+void tlb_flush(Tlb* tlb) {
+    memset(tlb->entries, 0, (size_t)tlb->num_sets * tlb->ways * sizeof(TlbEntry));
+}
+
+// Print hit rate and average translation cost
+void print_tlb_stats(const Tlb* tlb) {
+    static const char* policies[] = {"LRU", "FIFO", "random"};
+    long long translations = tlb->hits + tlb->misses;
+
+    printf("\nTLB: %d entries, %d-way, %s replacement%s\n", tlb->num_sets * tlb->ways,
+           tlb->ways, policies[tlb->policy], tlb->use_asid ? ", ASID tagged" : "");
+    printf("----------------------------------------\n");
+    printf("Translations: %lld\n", translations);
+    printf("Hits: %lld, misses: %lld, page faults: %lld\n", tlb->hits, tlb->misses,
+           tlb->faults);
+    printf("Hit rate: %.2f%%\n", translations ? 100.0 * tlb->hits / translations : 0.0);
+    printf("Average translation cost: %.2f cycles (hit %d, miss %d)\n",
+           translations ? (double)tlb->cycles / translations : 0.0, tlb->hit_cycles,
+           tlb->hit_cycles + tlb->miss_cycles);
+}
+
+void free_tlb(Tlb* tlb) {
+    free(tlb->entries);
+    free(tlb);
+}
@@ -0,0 +1,62 @@
+#ifndef TLB_H
+#define TLB_H
+
+#include <stdbool.h>
+
+#include "page_table.h"
+
+// Modelled cost of a translation: a hit is served by the TLB, a miss also
+// pays for walking the page table
+#define TLB_HIT_CYCLES 1
+#define TLB_MISS_CYCLES 30
+
+// Entry chosen for eviction when a set is full
+typedef enum {
+    TLB_LRU,
+    TLB_FIFO,
+    TLB_RANDOM
+} TlbPolicy;
+
+// One cached translation. key is page_key() of the virtual page, 0 when
+// the entry is empty. stamp is the last use (LRU) or the fill (FIFO).
+typedef struct {
+    unsigned int key;
+    int asid;
+    int physical_frame;
+    unsigned int stamp;
+} TlbEntry;
+
+// Set-associative TLB in front of a hash page table. A virtual page maps
+// to the set picked by its low bits and may sit in any of its ways. With
+// ASID tagging, entries of every address space stay cached across
+// switches; without it, a switch flushes the TLB.
+typedef struct {
+    TlbEntry* entries;       // num_sets rows of ways entries
+    int num_sets;            // Power of two
+    int ways;
+    TlbPolicy policy;
+    bool use_asid;
+    int asid;
+    HashPageTable* table;    // Page table of the current address space
+    unsigned int clock;
+    unsigned int random_state;
+
+    int hit_cycles;
+    int miss_cycles;
+    long long hits;
+    long long misses;
+    long long faults;        // Misses the page table could not translate
+    long long cycles;
+} Tlb;
+
+// num_entries must be a multiple of ways, giving a power-of-two number of
+// sets. Returns NULL for any other geometry.
+Tlb* init_tlb(HashPageTable* table, int num_entries, int ways, TlbPolicy policy, bool use_asid);
+int tlb_translate(Tlb* tlb, int virtual_page);
+void tlb_switch(Tlb* tlb, int asid, HashPageTable* table);
+void tlb_invalidate(Tlb* tlb, int virtual_page);
+void tlb_flush(Tlb* tlb);
+void print_tlb_stats(const Tlb* tlb);
+void free_tlb(Tlb* tlb);
+
+#endif
@@ -1,76 +1,61 @@
+// FIFO page replacement simulator.
+// Build: gcc fifo.c ../policy.c ../policies.c ../trace.c ../event_sink.c -pthread
+// Usage: fifo [-o OUTPUT] [TRACE [FRAMES]], replaying the built-in
+// reference string with 3 frames when no trace is given.
+// OUTPUT is verbose (every reference, the default without a trace),
+// summary (totals only, the default with one), sample:N, csv:FILE or
+// binary:FILE.
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 
-#define MAX_FRAMES 10
-#define MAX_PAGES 20
-
-// Function to check if a page exists in frames
-bool page_exists(int page, int frames[], int num_frames) {
-    for (int i = 0; i < num_frames; i++) {
-        if (frames[i] == page) {
-            return true;
-        }
-    }
-    return false;
-}
+#include "../trace.h"
+#include "../event_sink.h"
+#include "../policy.h"
 
 // FIFO page replacement algorithm
-void fifo_page_replacement(int pages[], int n, int num_frames) {
-    int frames[MAX_FRAMES];
-    int page_faults = 0;
-    int frame_index = 0;  // Points to the frame where next page will be placed
-
-    // Initialize frames with -1 to indicate empty
-    for (int i = 0; i < num_frames; i++) {
-        frames[i] = -1;
-    }
+void fifo_page_replacement(TraceReader* trace, int num_frames, EventSink* sink) {
+    ReplacementPolicy* policy = create_fifo_policy(num_frames);
+    FrameTable* table = init_frame_table(num_frames, policy);
 
     printf("\nFIFO Page Replacement Simulation:\n");
     printf("--------------------------------\n");
     
-    for (int i = 0; i < n; i++) {
-        printf("\nReferencing page %d: ", pages[i]);
-        
-        if (!page_exists(pages[i], frames, num_frames)) {
-            // Page fault occurred
-            page_faults++;
-            
-            // Replace page at current frame_index (FIFO)
-            frames[frame_index] = pages[i];
-            frame_index = (frame_index + 1) % num_frames;
-            
-            printf("Page Fault! ");
-        } else {
-            printf("Page Hit! ");
-        }
-        
-        // Print current state of frames
-        printf("Frames: ");
-        for (int j = 0; j < num_frames; j++) {
-            if (frames[j] == -1) {
-                printf("[ ] ");
-            } else {
-                printf("[%d] ", frames[j]);
-            }
-        }
-    }
+    long n = simulate(table, trace, sink);
     
-    printf("\n\nTotal page faults: %d\n", page_faults);
-    printf("Page fault rate: %.2f%%\n", (float)page_faults/n * 100);
+    printf("\n\nTotal page faults: %ld\n", table->faults);
+    printf("Page fault rate: %.2f%%\n", (float)table->faults/n * 100);
+    free_frame_table(table);
+    free_policy(policy);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    const char* output = take_option(&argc, argv, "-o");
+
     // Test case
     int pages[] = {1, 2, 3, 4, 1, 2, 5, 1, 2, 3, 4, 5};
     int n = sizeof(pages)/sizeof(pages[0]);
-    int num_frames = 3;
+    int num_frames = argc > 2 ? atoi(argv[2]) : 3;
+
+    if (num_frames <= 0) {
+        printf("Error: Number of frames must be positive\n");
+        return 1;
+    }
 
-    printf("Page Reference String: ");
-    for (int i = 0; i < n; i++) {
-        printf("%d ", pages[i]);
+    EventSink* sink = open_event_sink(output != NULL ? output : argc > 1 ? "summary" : "verbose",
+                                      NULL);
+    if (sink == NULL) {
+        return 1;
+    }
+
+    TraceReader* trace = open_simulation_trace(argc, argv, pages, n);
+    if (trace == NULL) {
+        close_event_sink(sink);
+        return 1;
     }
     printf("\nNumber of frames: %d", num_frames);
 
-    fifo_page_replacement(pages, n, num_frames);
-    return 0;
-}
\ No newline at end of file
+    fifo_page_replacement(trace, num_frames, sink);
+    close_trace(trace);
+    return close_event_sink(sink) ? 0 : 1;
+}
@@ -1,10 +1,22 @@
+// Demand paging simulator.
+// Build: gcc demand.c ../policy.c ../policies.c ../trace.c ../event_sink.c -pthread
+// Usage: demand [-o OUTPUT] [TRACE], replaying the built-in reference
+// string when no trace is given.
+// OUTPUT is verbose (every reference, the default without a trace),
+// summary (totals only, the default with one), sample:N, csv:FILE or
+// binary:FILE.
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "../trace.h"
+#include "../event_sink.h"
+#include "../policy.h"
 
 // Basic configuration
 #define FRAMES 3  // Number of frames in physical memory
-#define PAGES 5   // Number of pages in reference string
 
-void displayFrames(int frames[], int n) {
+void displayFrames(const int frames[], int n) {
     printf("\nFrames: ");
     for(int i = 0; i < n; i++) {
         if(frames[i] == -1)
@@ -15,61 +27,54 @@ void displayFrames(int frames[], int n) {
     printf("\n");
 }
 
-int isPagePresent(int frames[], int n, int page) {
-    for(int i = 0; i < n; i++) {
-        if(frames[i] == page)
-            return 1;
-    }
-    return 0;
+// Print a request with the frames after it
+void printRequest(const ReferenceEvent* event, const int frames[], int n) {
+    printf("\nRequesting Page %d: ", event->page);
+    if(event->fault)
+        printf("Page Fault!");
+    else
+        printf("Page Hit!");
+    displayFrames(frames, n);
 }
 
-void demandPaging(int pages[], int n) {
-    // Initialize frames with -1 (empty)
-    int frames[FRAMES];
-    for(int i = 0; i < FRAMES; i++) {
-        frames[i] = -1;
-    }
-    
-    int page_faults = 0;
-    int current_position = 0;  // For FIFO replacement
+// Pages are loaded on their first reference and replaced in FIFO order
+void demandPaging(TraceReader* trace, EventSink* sink) {
+    ReplacementPolicy* policy = create_fifo_policy(FRAMES);
+    FrameTable* table = init_frame_table(FRAMES, policy);
     
     printf("\nDemand Paging Simulation\n");
     printf("------------------------\n");
     
     // Process each page request
-    for(int i = 0; i < n; i++) {
-        printf("\nRequesting Page %d: ", pages[i]);
-        
-        // Check if page is already present
-        if(!isPagePresent(frames, FRAMES, pages[i])) {
-            // Page fault - need to load the page
-            frames[current_position] = pages[i];
-            current_position = (current_position + 1) % FRAMES;
-            page_faults++;
-            printf("Page Fault!");
-        } else {
-            printf("Page Hit!");
-        }
-        
-        // Display current state of frames
-        displayFrames(frames, FRAMES);
-    }
+    long n = simulate(table, trace, sink);
     
     // Display final statistics
-    printf("\nTotal Page Faults: %d\n", page_faults);
-    printf("Page Fault Rate: %.2f%%\n", (float)page_faults/n * 100);
+    printf("\nTotal Page Faults: %ld\n", table->faults);
+    printf("Page Fault Rate: %.2f%%\n", (float)table->faults/n * 100);
+    free_frame_table(table);
+    free_policy(policy);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    const char* output = take_option(&argc, argv, "-o");
+
     // Page reference string
     int pages[] = {1, 2, 3, 2, 1, 5, 2, 1, 6, 2, 5, 6, 3, 1, 3};
     int n = sizeof(pages)/sizeof(pages[0]);
     
-    printf("Page Reference String: ");
-    for(int i = 0; i < n; i++) {
-        printf("%d ", pages[i]);
+    EventSink* sink = open_event_sink(output != NULL ? output : argc > 1 ? "summary" : "verbose",
+                                      printRequest);
+    if(sink == NULL) {
+        return 1;
+    }
+
+    TraceReader* trace = open_simulation_trace(argc, argv, pages, n);
+    if(trace == NULL) {
+        close_event_sink(sink);
+        return 1;
     }
     
-    demandPaging(pages, n);
-    return 0;
-}
\ No newline at end of file
+    demandPaging(trace, sink);
+    close_trace(trace);
+    return close_event_sink(sink) ? 0 : 1;
+}
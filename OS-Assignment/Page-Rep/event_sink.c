@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_sink.h"
+
+// Writer thread: write each buffer handed over until the sink is closed
+static void* write_buffers(void* arg) {
+    EventSink* sink = (EventSink*)arg;
+
+    pthread_mutex_lock(&sink->lock);
+    for (;;) {
+        while (sink->pending == NULL && !sink->stop) {
+            pthread_cond_wait(&sink->changed, &sink->lock);
+        }
+        if (sink->pending == NULL) {
+            break;
+        }
+
+        char* buffer = sink->pending;
+        size_t bytes = sink->pending_bytes;
+        pthread_mutex_unlock(&sink->lock);
+        bool written = fwrite(buffer, 1, bytes, sink->file) == bytes;
+        pthread_mutex_lock(&sink->lock);
+
+        sink->ok = sink->ok && written;
+        sink->pending = NULL;
+        pthread_cond_broadcast(&sink->changed);
+    }
+    pthread_mutex_unlock(&sink->lock);
+    return NULL;
+}
+
+// Hand the filled buffer to the writer and switch to the other one, once
+// the writer is done with it
+static void flush_buffer(EventSink* sink) {
+    pthread_mutex_lock(&sink->lock);
+    while (sink->pending != NULL) {
+        pthread_cond_wait(&sink->changed, &sink->lock);
+    }
+    sink->pending = sink->buffers[sink->active];
+    sink->pending_bytes = sink->used;
+    pthread_cond_broadcast(&sink->changed);
+    pthread_mutex_unlock(&sink->lock);
+
+    sink->active ^= 1;
+    sink->used = 0;
+}
+
+static bool open_log(EventSink* sink, const char* path) {
+    sink->file = fopen(path, sink->mode == SINK_BINARY ? "wb" : "w");
+    if (sink->file == NULL) {
+        printf("Error: Cannot write event log %s\n", path);
+        return false;
+    }
+    setvbuf(sink->file, NULL, _IONBF, 0);   // Buffers are already large
+
+    sink->buffers[0] = (char*)malloc(SINK_BUFFER_BYTES);
+    sink->buffers[1] = (char*)malloc(SINK_BUFFER_BYTES);
+    sink->ok = true;
+    pthread_mutex_init(&sink->lock, NULL);
+    pthread_cond_init(&sink->changed, NULL);
+    pthread_create(&sink->writer, NULL, write_buffers, sink);
+
+    if (sink->mode == SINK_CSV) {
+        const char* header = "reference,page,fault,evicted\n";
+        memcpy(sink->buffers[0], header, strlen(header));
+        sink->used = strlen(header);
+    }
+    return true;
+}
+
+EventSink* open_event_sink(const char* spec, PrintReference print) {
+    EventSink* sink = (EventSink*)calloc(1, sizeof(EventSink));
+    sink->print = print != NULL ? print : print_reference_line;
+
+    bool valid = true;
+    if (strcmp(spec, "verbose") == 0) {
+        sink->mode = SINK_VERBOSE;
+    } else if (strcmp(spec, "summary") == 0) {
+        sink->mode = SINK_SUMMARY;
+    } else if (strncmp(spec, "sample:", 7) == 0) {
+        sink->mode = SINK_SAMPLED;
+        sink->sample_every = atol(spec + 7);
+        valid = sink->sample_every > 0;
+    } else if (strncmp(spec, "csv:", 4) == 0 || strncmp(spec, "binary:", 7) == 0) {
+        sink->mode = spec[0] == 'c' ? SINK_CSV : SINK_BINARY;
+        if (!open_log(sink, strchr(spec, ':') + 1)) {
+            free(sink);
+            return NULL;
+        }
+    } else {
+        valid = false;
+    }
+
+    if (!valid) {
+        printf("Error: Unknown output %s (verbose, summary, sample:N, csv:FILE, binary:FILE)\n",
+               spec);
+        free(sink);
+        return NULL;
+    }
+    return sink;
+}
+
+// Append a number in decimal, returning its length
+static size_t append_number(char* out, long value) {
+    char digits[24];
+    size_t length = 0;
+    unsigned long magnitude = value < 0 ? -(unsigned long)value : (unsigned long)value;
+
+    do {
+        digits[length++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    size_t written = 0;
+    if (value < 0) {
+        out[written++] = '-';
+    }
+    while (length > 0) {
+        out[written++] = digits[--length];
+    }
+    return written;
+}
+
+void record_reference(EventSink* sink, int page, bool fault, int evicted,
+                      const int frames[], int num_frames) {
+    long index = sink->references++;
+    sink->faults += fault;
+
+    switch (sink->mode) {
+        case SINK_SUMMARY:
+            return;
+        case SINK_SAMPLED:
+            if (index % sink->sample_every != 0) {
+                return;
+            }
+            // Fall through
+        case SINK_VERBOSE: {
+            ReferenceEvent event = {index, page, evicted, fault};
+            sink->print(&event, frames, num_frames);
+            return;
+        }
+        case SINK_CSV:
+        case SINK_BINARY:
+            break;
+    }
+
+    if (sink->used + SINK_RECORD_MAX > SINK_BUFFER_BYTES) {
+        flush_buffer(sink);
+    }
+    char* out = sink->buffers[sink->active] + sink->used;
+    if (sink->mode == SINK_BINARY) {
+        EventRecord record = {page, evicted, fault};
+        memcpy(out, &record, sizeof(record));
+        sink->used += sizeof(record);
+    } else {
+        size_t length = append_number(out, index);
+        out[length++] = ',';
+        length += append_number(out + length, page);
+        out[length++] = ',';
+        out[length++] = fault ? '1' : '0';
+        out[length++] = ',';
+        length += append_number(out + length, evicted);
+        out[length++] = '\n';
+        sink->used += length;
+    }
+}
+
+bool close_event_sink(EventSink* sink) {
+    bool ok = true;
+    if (sink->file != NULL) {
+        if (sink->used > 0) {
+            flush_buffer(sink);
+        }
+        pthread_mutex_lock(&sink->lock);
+        sink->stop = true;
+        pthread_cond_broadcast(&sink->changed);
+        pthread_mutex_unlock(&sink->lock);
+        pthread_join(sink->writer, NULL);
+
+        ok = fclose(sink->file) == 0 && sink->ok;
+        if (!ok) {
+            printf("Error: Cannot write event log\n");
+        }
+        pthread_mutex_destroy(&sink->lock);
+        pthread_cond_destroy(&sink->changed);
+        free(sink->buffers[0]);
+        free(sink->buffers[1]);
+    }
+    free(sink);
+    return ok;
+}
+
+// The line the simulators have always printed for a reference
+void print_reference_line(const ReferenceEvent* event, const int frames[], int num_frames) {
+    printf("\nReferencing page %d: ", event->page);
+    if (event->fault) {
+        printf("Page Fault! ");
+    } else {
+        printf("Page Hit! ");
+    }
+
+    // Print current state of frames
+    printf("Frames: ");
+    for (int j = 0; j < num_frames; j++) {
+        if (frames[j] == -1) {
+            printf("[ ] ");
+        } else {
+            printf("[%d] ", frames[j]);
+        }
+    }
+}
+
+const char* take_option(int* argc, char* argv[], const char* name) {
+    for (int i = 1; i + 1 < *argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            const char* value = argv[i + 1];
+            for (int j = i; j + 2 <= *argc; j++) {
+                argv[j] = argv[j + 2];
+            }
+            *argc -= 2;
+            return value;
+        }
+    }
+    return NULL;
+}
+
+void print_fault_curve(const char* name, const long faults[], int max_frames, long n) {
+    printf("\n%s fault curve:\n", name);
+    printf("Frames  Faults  Fault rate\n");
+    for (int frames = 1; frames <= max_frames; frames++) {
+        printf("%6d  %6ld  %9.2f%%\n", frames, faults[frames], (float)faults[frames]/n * 100);
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef EVENT_SINK_H
+#define EVENT_SINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#define SINK_BUFFER_BYTES (4 << 20)  // Size of each of the two log buffers
+#define SINK_RECORD_MAX 64           // Longest single CSV line or record
+
+// What happens to each reference a simulator makes
+typedef enum {
+    SINK_VERBOSE,   // Print every reference with the frames after it
+    SINK_SUMMARY,   // Only count; the simulator prints its totals
+    SINK_SAMPLED,   // Print every sample_every-th reference
+    SINK_CSV,       // Log every reference as a CSV line
+    SINK_BINARY     // Log every reference as an EventRecord
+} SinkMode;
+
+typedef struct {
+    long index;      // Position in the trace
+    int page;
+    int evicted;     // Page replaced by a fault, -1 if none
+    bool fault;
+} ReferenceEvent;
+
+// Record of a binary event log; the position in the file is the index
+typedef struct {
+    int page;
+    int evicted;
+    int fault;
+} EventRecord;
+
+// Prints one reference in the verbose and sampled modes
+typedef void (*PrintReference)(const ReferenceEvent* event, const int frames[], int num_frames);
+
+// Destination for the events of one simulation. Logs are formatted into
+// one buffer while a writer thread writes the other, so the simulation
+// only waits for the disk when it gets a whole buffer ahead of it.
+typedef struct {
+    SinkMode mode;
+    long sample_every;
+    long references;
+    long faults;
+    PrintReference print;
+
+    FILE* file;
+    char* buffers[2];
+    int active;              // Buffer being filled
+    size_t used;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    char* pending;           // Buffer handed to the writer, NULL once written
+    size_t pending_bytes;
+    bool stop;
+    bool ok;
+} EventSink;
+
+// Open a sink from a spec: verbose, summary, sample:N, csv:FILE or
+// binary:FILE. print formats references for the printing modes; NULL
+// gives the usual "Referencing page" line.
+EventSink* open_event_sink(const char* spec, PrintReference print);
+void record_reference(EventSink* sink, int page, bool fault, int evicted,
+                      const int frames[], int num_frames);
+// Flush and free the sink; false if the log could not be written
+bool close_event_sink(EventSink* sink);
+
+void print_reference_line(const ReferenceEvent* event, const int frames[], int num_frames);
+// Remove "name VALUE" from the command line and return VALUE, or NULL
+const char* take_option(int* argc, char* argv[], const char* name);
+// Print the faults and fault rate of 1 to max_frames frames, from
+// faults[frames], over a trace of n references
+void print_fault_curve(const char* name, const long faults[], int max_frames, long n);
+
+#endif
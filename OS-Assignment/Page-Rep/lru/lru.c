@@ -1,99 +1,142 @@
+// LRU page replacement simulator.
+// Build: gcc lru.c ../policy.c ../policies.c ../trace.c ../event_sink.c -pthread
+// Usage: lru [-o OUTPUT] [-c CURVE_FRAMES] [TRACE [FRAMES]], replaying the
+// built-in reference string with 3 frames when no trace is given. -c also
+// prints the fault curve of 1 to CURVE_FRAMES frames, taking one more pass
+// over a trace of at most INT_MAX references.
+// OUTPUT is verbose (every reference, the default without a trace),
+// summary (totals only, the default with one), sample:N, csv:FILE or
+// binary:FILE.
 #include <stdio.h>
+#include <stdlib.h>
 #include <limits.h>
 #include <stdbool.h>
 
-#define MAX_FRAMES 10
-#define MAX_PAGES 20
-
-// Structure to store page information
-typedef struct {
-    int page_number;
-    int last_used;  // Timestamp of last usage
-} Page;
+#include "../trace.h"
+#include "../event_sink.h"
+#include "../policy.h"
 
 // LRU page replacement algorithm
-void lru_page_replacement(int pages[], int n, int num_frames) {
-    Page frames[MAX_FRAMES];
-    int page_faults = 0;
-    int current_time = 0;
-
-    // Initialize frames
-    for (int i = 0; i < num_frames; i++) {
-        frames[i].page_number = -1;
-        frames[i].last_used = -1;
-    }
+void lru_page_replacement(TraceReader* trace, int num_frames, EventSink* sink) {
+    ReplacementPolicy* policy = create_lru_policy(num_frames);
+    FrameTable* table = init_frame_table(num_frames, policy);
 
     printf("\nLRU Page Replacement Simulation:\n");
     printf("--------------------------------\n");
     
-    for (int i = 0; i < n; i++) {
-        printf("\nReferencing page %d: ", pages[i]);
-        
-        // Check if page already exists
-        bool page_found = false;
-        for (int j = 0; j < num_frames; j++) {
-            if (frames[j].page_number == pages[i]) {
-                frames[j].last_used = current_time;
-                page_found = true;
-                printf("Page Hit! ");
-                break;
-            }
-        }
+    long n = simulate(table, trace, sink);
+    
+    printf("\n\nTotal page faults: %ld\n", table->faults);
+    printf("Page fault rate: %.2f%%\n", (float)table->faults/n * 100);
+    free_frame_table(table);
+    free_policy(policy);
+}
 
-        if (!page_found) {
-            page_faults++;
-            
-            // Find the least recently used page
-            int lru_index = 0;
-            int oldest_time = INT_MAX;
-            
-            for (int j = 0; j < num_frames; j++) {
-                if (frames[j].page_number == -1) {
-                    // Found an empty frame
-                    lru_index = j;
-                    break;
-                }
-                if (frames[j].last_used < oldest_time) {
-                    oldest_time = frames[j].last_used;
-                    lru_index = j;
+// Fenwick tree over reference times, counting the pages whose most recent
+// reference is at each time
+void fenwick_add(int tree[], int n, int index, int delta) {
+    for (index++; index <= n; index += index & -index) {
+        tree[index] += delta;
+    }
+}
+
+// Sum of the counts at times 0..index-1
+int fenwick_sum(const int tree[], int index) {
+    int sum = 0;
+    for (; index > 0; index -= index & -index) {
+        sum += tree[index];
+    }
+    return sum;
+}
+
+// LRU fault counts of every memory size from 1 to max_frames in a single
+// pass (Mattson's stack algorithm). A reference hits in f frames exactly
+// when fewer than f distinct pages were referenced since the page's last
+// use; that stack distance is the number of pages last used after it,
+// counted in O(log n). faults must have room for max_frames + 1 entries.
+void lru_fault_curve(TraceReader* trace, int max_frames, long faults[]) {
+    int n = (int)trace_length(trace);
+    int* tree = (int*)calloc(n + 1, sizeof(int));
+    long* hits = (long*)calloc(max_frames + 1, sizeof(long));  // By stack distance
+    int* pages = (int*)malloc(TRACE_CHUNK * sizeof(int));
+    PageMap last_used;
+    page_map_init(&last_used, 64);
+
+    int time = 0;
+    int count;
+    while ((count = read_trace(trace, pages, TRACE_CHUNK)) > 0) {
+        for (int i = 0; i < count; i++, time++) {
+            int last = page_map_get(&last_used, pages[i]);
+            if (last != -1) {
+                int distance = fenwick_sum(tree, time) - fenwick_sum(tree, last + 1) + 1;
+                if (distance <= max_frames) {
+                    hits[distance]++;
                 }
+                fenwick_add(tree, n, last, -1);
             }
-            
-            // Replace the page
-            frames[lru_index].page_number = pages[i];
-            frames[lru_index].last_used = current_time;
-            printf("Page Fault! ");
+            fenwick_add(tree, n, time, 1);
+            page_map_put(&last_used, pages[i], time);
         }
-        
-        // Print current state of frames
-        printf("Frames: ");
-        for (int j = 0; j < num_frames; j++) {
-            if (frames[j].page_number == -1) {
-                printf("[ ] ");
-            } else {
-                printf("[%d] ", frames[j].page_number);
-            }
-        }
-        
-        current_time++;
     }
-    
-    printf("\n\nTotal page faults: %d\n", page_faults);
-    printf("Page fault rate: %.2f%%\n", (float)page_faults/n * 100);
+
+    // Memory of f frames hits every reference with distance f or less
+    faults[0] = time;
+    for (int frames = 1; frames <= max_frames; frames++) {
+        faults[frames] = faults[frames - 1] - hits[frames];
+    }
+
+    page_map_free(&last_used);
+    free(pages);
+    free(hits);
+    free(tree);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    const char* output = take_option(&argc, argv, "-o");
+    const char* curve = take_option(&argc, argv, "-c");
+
     // Test case
     int pages[] = {1, 2, 3, 4, 1, 2, 5, 1, 2, 3, 4, 5};
     int n = sizeof(pages)/sizeof(pages[0]);
-    int num_frames = 3;
+    int num_frames = argc > 2 ? atoi(argv[2]) : 3;
+    int max_frames = curve != NULL ? atoi(curve) : 0;
+
+    if (num_frames <= 0 || (curve != NULL && max_frames <= 0)) {
+        printf("Error: Number of frames must be positive\n");
+        return 1;
+    }
+
+    EventSink* sink = open_event_sink(output != NULL ? output : argc > 1 ? "summary" : "verbose",
+                                      NULL);
+    if (sink == NULL) {
+        return 1;
+    }
 
-    printf("Page Reference String: ");
-    for (int i = 0; i < n; i++) {
-        printf("%d ", pages[i]);
+    TraceReader* trace = open_simulation_trace(argc, argv, pages, n);
+    if (trace == NULL) {
+        close_event_sink(sink);
+        return 1;
+    }
+    // The curve indexes references with ints
+    if (curve != NULL && trace_length(trace) > INT_MAX) {
+        printf("\nError: Trace is too long for a fault curve\n");
+        close_event_sink(sink);
+        close_trace(trace);
+        return 1;
     }
     printf("\nNumber of frames: %d", num_frames);
 
-    lru_page_replacement(pages, n, num_frames);
-    return 0;
-}
\ No newline at end of file
+    lru_page_replacement(trace, num_frames, sink);
+    bool ok = close_event_sink(sink);
+
+    // Faults of every memory size from the same trace, in one more pass
+    if (curve != NULL) {
+        long* faults = (long*)malloc((max_frames + 1) * sizeof(long));
+        rewind_trace(trace);
+        lru_fault_curve(trace, max_frames, faults);
+        print_fault_curve("LRU", faults, max_frames, trace_length(trace));
+        free(faults);
+    }
+    close_trace(trace);
+    return ok ? 0 : 1;
+}
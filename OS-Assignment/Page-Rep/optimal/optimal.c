@@ -1,108 +1,149 @@
+// Optimal (Belady's) page replacement simulator.
+// Build: gcc optimal.c ../policy.c ../policies.c ../trace.c ../event_sink.c -pthread
+// Usage: optimal [-o OUTPUT] [-c CURVE_FRAMES] [TRACE [FRAMES]], replaying
+// the built-in reference string with 3 frames when no trace is given. -c
+// also prints the fault curve of 1 to CURVE_FRAMES frames.
+// OUTPUT is verbose (every reference, the default without a trace),
+// summary (totals only, the default with one), sample:N, csv:FILE or
+// binary:FILE.
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <limits.h>
 
-#define MAX_FRAMES 10
-#define MAX_PAGES 20
+#include "../trace.h"
+#include "../event_sink.h"
+#include "../policy.h"
 
-// Function to find the next occurrence of a page in the future
-int find_next_occurrence(int page, int pages[], int current_pos, int n) {
-    for (int i = current_pos + 1; i < n; i++) {
-        if (pages[i] == page) {
-            return i;
-        }
-    }
-    return INT_MAX;  // Page won't be used again
-}
-
-// Function to check if a page exists in frames
-bool page_exists(int page, int frames[], int num_frames) {
-    for (int i = 0; i < num_frames; i++) {
-        if (frames[i] == page) {
-            return true;
-        }
-    }
-    return false;
-}
-
-// Optimal page replacement algorithm
-void optimal_page_replacement(int pages[], int n, int num_frames) {
-    int frames[MAX_FRAMES];
-    int page_faults = 0;
-
-    // Initialize frames with -1 to indicate empty
-    for (int i = 0; i < num_frames; i++) {
-        frames[i] = -1;
-    }
+// Optimal page replacement algorithm. Each reference costs O(log frames):
+// the frame of a page comes from a map, and the page used farthest in the
+// future is always on top of a heap.
+void optimal_page_replacement(int pages[], int n, int num_frames, EventSink* sink) {
+    ReplacementPolicy* policy = create_opt_policy(num_frames, pages, n);
+    FrameTable* table = init_frame_table(num_frames, policy);
+    TraceReader* trace = open_trace_array(pages, n);
 
     printf("\nOptimal (Belady's) Page Replacement Simulation:\n");
     printf("--------------------------------------------\n");
     
+    simulate(table, trace, sink);
+    
+    printf("\n\nTotal page faults: %ld\n", table->faults);
+    printf("Page fault rate: %.2f%%\n", (float)table->faults/n * 100);
+    close_trace(trace);
+    free_frame_table(table);
+    free_policy(policy);
+}
+
+// OPT fault counts of every memory size from 1 to max_frames in a single
+// pass. OPT is a stack algorithm: the pages OPT keeps in f frames are the
+// top f of one stack. A referenced page moves to the top, and each level
+// above its old position keeps whichever of its page and the page pushed
+// down from above is used sooner. Costs O(depth) per reference instead of
+// one simulation per memory size. faults must have room for max_frames + 1
+// entries.
+void optimal_fault_curve(int pages[], int n, int max_frames, long faults[]) {
+    int* next_use = (int*)malloc((n + 1) * sizeof(int));
+    int* stack = (int*)calloc(max_frames, sizeof(int));
+    int* stack_next = (int*)calloc(max_frames, sizeof(int));
+    long* hits = (long*)calloc(max_frames + 1, sizeof(long));  // By stack depth
+    int depth = 0;
+    build_next_use(pages, n, next_use);
+
     for (int i = 0; i < n; i++) {
-        printf("\nReferencing page %d: ", pages[i]);
-        
-        if (!page_exists(pages[i], frames, num_frames)) {
-            page_faults++;
-            
-            // Find if there's any empty frame
-            int empty_frame = -1;
-            for (int j = 0; j < num_frames; j++) {
-                if (frames[j] == -1) {
-                    empty_frame = j;
-                    break;
-                }
-            }
-            
-            if (empty_frame != -1) {
-                // If empty frame exists, use it
-                frames[empty_frame] = pages[i];
-            } else {
-                // Find the page that will not be used for the longest time
-                int farthest = -1;
-                int replace_index = 0;
-                
-                for (int j = 0; j < num_frames; j++) {
-                    int next = find_next_occurrence(frames[j], pages, i, n);
-                    if (next > farthest) {
-                        farthest = next;
-                        replace_index = j;
-                    }
-                }
-                
-                frames[replace_index] = pages[i];
-            }
-            printf("Page Fault! ");
-        } else {
-            printf("Page Hit! ");
+        // A page deeper than max_frames misses in every size we report, so
+        // the stack is cut off there and a miss pushes out its bottom page
+        int position = 0;
+        while (position < depth && stack[position] != pages[i]) {
+            position++;
+        }
+        if (position < depth) {
+            hits[position + 1]++;
+        } else if (depth < max_frames) {
+            depth++;
         }
-        
-        // Print current state of frames
-        printf("Frames: ");
-        for (int j = 0; j < num_frames; j++) {
-            if (frames[j] == -1) {
-                printf("[ ] ");
-            } else {
-                printf("[%d] ", frames[j]);
+
+        // Push down from the top, stopping at the page's old slot
+        int carried = stack[0];
+        int carried_next = stack_next[0];
+        for (int level = 1; level <= position && level < depth; level++) {
+            if (level == position) {
+                stack[level] = carried;
+                stack_next[level] = carried_next;
+            } else if (carried_next < stack_next[level]) {
+                int page = stack[level];
+                int next = stack_next[level];
+                stack[level] = carried;
+                stack_next[level] = carried_next;
+                carried = page;
+                carried_next = next;
             }
         }
+        stack[0] = pages[i];
+        stack_next[0] = next_use[i];
     }
-    
-    printf("\n\nTotal page faults: %d\n", page_faults);
-    printf("Page fault rate: %.2f%%\n", (float)page_faults/n * 100);
+
+    faults[0] = n;
+    for (int frames = 1; frames <= max_frames; frames++) {
+        faults[frames] = faults[frames - 1] - hits[frames];
+    }
+
+    free(hits);
+    free(stack_next);
+    free(stack);
+    free(next_use);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    const char* output = take_option(&argc, argv, "-o");
+    const char* curve = take_option(&argc, argv, "-c");
+
     // Test case
-    int pages[] = {1, 2, 3, 4, 1, 2, 5, 1, 2, 3, 4, 5};
-    int n = sizeof(pages)/sizeof(pages[0]);
-    int num_frames = 3;
+    int test_pages[] = {1, 2, 3, 4, 1, 2, 5, 1, 2, 3, 4, 5};
+    int num_frames = argc > 2 ? atoi(argv[2]) : 3;
+    int max_frames = curve != NULL ? atoi(curve) : 0;
 
-    printf("Page Reference String: ");
-    for (int i = 0; i < n; i++) {
-        printf("%d ", pages[i]);
+    if (num_frames <= 0 || (curve != NULL && max_frames <= 0)) {
+        printf("Error: Number of frames must be positive\n");
+        return 1;
+    }
+
+    EventSink* sink = open_event_sink(output != NULL ? output : argc > 1 ? "summary" : "verbose",
+                                      NULL);
+    if (sink == NULL) {
+        return 1;
+    }
+
+    TraceReader* trace = open_simulation_trace(argc, argv, test_pages,
+                                               sizeof(test_pages)/sizeof(test_pages[0]));
+    if (trace == NULL) {
+        close_event_sink(sink);
+        return 1;
+    }
+    if (trace_length(trace) > INT_MAX) {
+        printf("\nError: Trace is too long\n");
+        close_event_sink(sink);
+        close_trace(trace);
+        return 1;
     }
     printf("\nNumber of frames: %d", num_frames);
 
-    optimal_page_replacement(pages, n, num_frames);
-    return 0;
-}
\ No newline at end of file
+    // OPT looks ahead, so it needs the whole trace in memory
+    long length;
+    int* pages = load_trace(trace, &length);
+    int n = (int)length;
+    close_trace(trace);
+
+    optimal_page_replacement(pages, n, num_frames, sink);
+    bool ok = close_event_sink(sink);
+
+    // Faults of every memory size in one more pass
+    if (curve != NULL) {
+        long* faults = (long*)malloc((max_frames + 1) * sizeof(long));
+        optimal_fault_curve(pages, n, max_frames, faults);
+        print_fault_curve("Optimal", faults, max_frames, n);
+        free(faults);
+    }
+    free(pages);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,663 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "policy.h"
+
+static ReplacementPolicy* new_policy(const char* name, void* state,
+                                     void (*on_hit)(void*, int),
+                                     void (*on_miss)(void*, int, int),
+                                     int (*choose_victim)(void*, int),
+                                     void (*destroy)(void*)) {
+    ReplacementPolicy* policy = (ReplacementPolicy*)malloc(sizeof(ReplacementPolicy));
+    policy->name = name;
+    policy->state = state;
+    policy->on_hit = on_hit;
+    policy->on_miss = on_miss;
+    policy->choose_victim = choose_victim;
+    policy->destroy = destroy;
+    return policy;
+}
+
+// FIFO: frames are replaced round robin, which is load order since empty
+// frames are filled in index order
+
+typedef struct {
+    int num_frames;
+    int next;       // Points to the frame where next page will be placed
+} FifoState;
+
+static void fifo_on_hit(void* state, int frame) {
+    (void)state;
+    (void)frame;
+}
+
+static void fifo_on_miss(void* state, int page, int frame) {
+    (void)state;
+    (void)page;
+    (void)frame;
+}
+
+static int fifo_choose_victim(void* state, int page) {
+    FifoState* fifo = (FifoState*)state;
+    int frame = fifo->next;
+    (void)page;
+
+    fifo->next = (fifo->next + 1) % fifo->num_frames;
+    return frame;
+}
+
+ReplacementPolicy* create_fifo_policy(int num_frames) {
+    FifoState* fifo = (FifoState*)malloc(sizeof(FifoState));
+    fifo->num_frames = num_frames;
+    fifo->next = 0;
+    return new_policy("FIFO", fifo, fifo_on_hit, fifo_on_miss, fifo_choose_victim, free);
+}
+
+// LRU: frames are nodes of a recency list, most recent at the head
+
+typedef struct {
+    ListLinks links;
+    NodeList recency;
+} LruState;
+
+static void lru_on_hit(void* state, int frame) {
+    LruState* lru = (LruState*)state;
+    if (frame != lru->recency.head) {
+        list_remove(&lru->links, &lru->recency, frame);
+        list_push_front(&lru->links, &lru->recency, frame);
+    }
+}
+
+static void lru_on_miss(void* state, int page, int frame) {
+    LruState* lru = (LruState*)state;
+    (void)page;
+    list_push_front(&lru->links, &lru->recency, frame);
+}
+
+static int lru_choose_victim(void* state, int page) {
+    LruState* lru = (LruState*)state;
+    int frame = lru->recency.tail;
+    (void)page;
+
+    list_remove(&lru->links, &lru->recency, frame);
+    return frame;
+}
+
+static void lru_destroy(void* state) {
+    LruState* lru = (LruState*)state;
+    free_list_links(&lru->links);
+    free(lru);
+}
+
+ReplacementPolicy* create_lru_policy(int num_frames) {
+    LruState* lru = (LruState*)malloc(sizeof(LruState));
+    init_list_links(&lru->links, num_frames);
+    list_init(&lru->recency);
+    return new_policy("LRU", lru, lru_on_hit, lru_on_miss, lru_choose_victim, lru_destroy);
+}
+
+// OPT: a max-heap of frames keyed by the next use of the page they hold,
+// so the page used farthest in the future is always on top. Among pages
+// that are never used again the lowest frame comes first. The policy
+// counts references itself, so it must see exactly the reference string it
+// was created with.
+
+typedef struct {
+    const int* next_use;
+    int* owned;       // next_use when this policy built it, else NULL
+    int time;         // References seen so far
+    int* frames;      // Heap of frame indexes
+    int* position;    // Where each frame sits in the heap, -1 if not yet
+    int* key;         // Next use of the page in each frame
+    int size;
+} OptState;
+
+static bool heap_before(const OptState* heap, int a, int b) {
+    if (heap->key[a] != heap->key[b]) {
+        return heap->key[a] > heap->key[b];
+    }
+    return a < b;
+}
+
+static void heap_swap(OptState* heap, int i, int j) {
+    int a = heap->frames[i];
+    int b = heap->frames[j];
+    heap->frames[i] = b;
+    heap->frames[j] = a;
+    heap->position[b] = i;
+    heap->position[a] = j;
+}
+
+static void heap_sift_up(OptState* heap, int i) {
+    while (i > 0 && heap_before(heap, heap->frames[i], heap->frames[(i - 1) / 2])) {
+        heap_swap(heap, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void heap_sift_down(OptState* heap, int i) {
+    for (;;) {
+        int best = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < heap->size && heap_before(heap, heap->frames[left], heap->frames[best])) {
+            best = left;
+        }
+        if (right < heap->size && heap_before(heap, heap->frames[right], heap->frames[best])) {
+            best = right;
+        }
+        if (best == i) {
+            return;
+        }
+        heap_swap(heap, i, best);
+        i = best;
+    }
+}
+
+static void opt_on_hit(void* state, int frame) {
+    OptState* opt = (OptState*)state;
+
+    // The page's next use moves further out
+    opt->key[frame] = opt->next_use[opt->time++];
+    heap_sift_up(opt, opt->position[frame]);
+}
+
+static void opt_on_miss(void* state, int page, int frame) {
+    OptState* opt = (OptState*)state;
+    (void)page;
+
+    opt->key[frame] = opt->next_use[opt->time++];
+    if (opt->position[frame] == -1) {
+        opt->frames[opt->size] = frame;
+        opt->position[frame] = opt->size++;
+    }
+    heap_sift_up(opt, opt->position[frame]);
+    heap_sift_down(opt, opt->position[frame]);
+}
+
+// Replace the page that will not be used for the longest time
+static int opt_choose_victim(void* state, int page) {
+    OptState* opt = (OptState*)state;
+    (void)page;
+    return opt->frames[0];
+}
+
+static void opt_destroy(void* state) {
+    OptState* opt = (OptState*)state;
+    free(opt->owned);
+    free(opt->frames);
+    free(opt->position);
+    free(opt->key);
+    free(opt);
+}
+
+ReplacementPolicy* create_opt_policy_with_index(int num_frames, const int next_use[]) {
+    OptState* opt = (OptState*)malloc(sizeof(OptState));
+    opt->next_use = next_use;
+    opt->owned = NULL;
+    opt->time = 0;
+    opt->frames = (int*)malloc(num_frames * sizeof(int));
+    opt->position = (int*)malloc(num_frames * sizeof(int));
+    opt->key = (int*)malloc(num_frames * sizeof(int));
+    opt->size = 0;
+
+    for (int i = 0; i < num_frames; i++) {
+        opt->position[i] = -1;
+    }
+    return new_policy("Optimal (Belady's)", opt, opt_on_hit, opt_on_miss, opt_choose_victim,
+                      opt_destroy);
+}
+
+ReplacementPolicy* create_opt_policy(int num_frames, const int pages[], int n) {
+    int* next_use = (int*)malloc((n + 1) * sizeof(int));
+    build_next_use(pages, n, next_use);
+
+    ReplacementPolicy* policy = create_opt_policy_with_index(num_frames, next_use);
+    ((OptState*)policy->state)->owned = next_use;
+    return policy;
+}
+
+// CLOCK (second chance): a hand sweeps the frames in order, clearing
+// reference bits, and replaces the first frame whose bit is already clear
+
+typedef struct {
+    int num_frames;
+    int hand;
+    unsigned char* referenced;
+} ClockState;
+
+static void clock_on_hit(void* state, int frame) {
+    ((ClockState*)state)->referenced[frame] = 1;
+}
+
+static void clock_on_miss(void* state, int page, int frame) {
+    (void)page;
+    ((ClockState*)state)->referenced[frame] = 1;
+}
+
+static int clock_choose_victim(void* state, int page) {
+    ClockState* clock = (ClockState*)state;
+    (void)page;
+
+    while (clock->referenced[clock->hand]) {
+        clock->referenced[clock->hand] = 0;
+        clock->hand = (clock->hand + 1) % clock->num_frames;
+    }
+    int frame = clock->hand;
+    clock->hand = (clock->hand + 1) % clock->num_frames;
+    return frame;
+}
+
+static void clock_destroy(void* state) {
+    ClockState* clock = (ClockState*)state;
+    free(clock->referenced);
+    free(clock);
+}
+
+ReplacementPolicy* create_clock_policy(int num_frames) {
+    ClockState* clock = (ClockState*)malloc(sizeof(ClockState));
+    clock->num_frames = num_frames;
+    clock->hand = 0;
+    clock->referenced = (unsigned char*)calloc(num_frames, 1);
+    return new_policy("CLOCK", clock, clock_on_hit, clock_on_miss, clock_choose_victim,
+                      clock_destroy);
+}
+
+// Aging (NFU with decay): every frame has an 8-bit counter. On each tick
+// the counters shift right and the reference bit enters at the top, and
+// the victim is the frame with the smallest counter, frames referenced
+// since the last tick counting as larger than all others. Frames are kept
+// in one list per counter value plus one for referenced frames, with a
+// bitmap of non-empty lists, so a victim is found in O(1). A tick comes
+// every num_frames references and rebuilds the lists, which is O(1) per
+// reference amortized.
+
+#define AGING_REFERENCED AGING_LEVELS   // List of frames referenced since the tick
+#define AGING_WORDS ((AGING_LEVELS + 64) / 64)
+
+typedef struct {
+    int num_frames;
+    int until_tick;
+    unsigned char* counter;
+    unsigned char* referenced;
+    int* level;                     // List each frame is on, -1 if none
+    ListLinks links;
+    NodeList levels[AGING_LEVELS + 1];
+    unsigned long long nonempty[AGING_WORDS];
+} AgingState;
+
+static void aging_insert(AgingState* aging, int frame, int level) {
+    list_push_back(&aging->links, &aging->levels[level], frame);
+    aging->level[frame] = level;
+    aging->nonempty[level / 64] |= 1ULL << (level % 64);
+}
+
+static void aging_erase(AgingState* aging, int frame) {
+    int level = aging->level[frame];
+    list_remove(&aging->links, &aging->levels[level], frame);
+    aging->level[frame] = -1;
+    if (aging->levels[level].size == 0) {
+        aging->nonempty[level / 64] &= ~(1ULL << (level % 64));
+    }
+}
+
+static void aging_tick(AgingState* aging) {
+    for (int level = 0; level <= AGING_LEVELS; level++) {
+        list_init(&aging->levels[level]);
+    }
+    memset(aging->nonempty, 0, sizeof(aging->nonempty));
+
+    for (int frame = 0; frame < aging->num_frames; frame++) {
+        if (aging->level[frame] == -1) {
+            continue;
+        }
+        aging->counter[frame] = (unsigned char)((aging->counter[frame] >> 1) |
+                                                (aging->referenced[frame] ? 0x80 : 0));
+        aging->referenced[frame] = 0;
+        aging_insert(aging, frame, aging->counter[frame]);
+    }
+}
+
+static void aging_count(AgingState* aging) {
+    if (--aging->until_tick == 0) {
+        aging_tick(aging);
+        aging->until_tick = aging->num_frames;
+    }
+}
+
+static void aging_on_hit(void* state, int frame) {
+    AgingState* aging = (AgingState*)state;
+    if (!aging->referenced[frame]) {
+        aging_erase(aging, frame);
+        aging->referenced[frame] = 1;
+        aging_insert(aging, frame, AGING_REFERENCED);
+    }
+    aging_count(aging);
+}
+
+static void aging_on_miss(void* state, int page, int frame) {
+    AgingState* aging = (AgingState*)state;
+    (void)page;
+
+    aging->counter[frame] = 0;
+    aging->referenced[frame] = 1;
+    aging_insert(aging, frame, AGING_REFERENCED);
+    aging_count(aging);
+}
+
+static int aging_choose_victim(void* state, int page) {
+    AgingState* aging = (AgingState*)state;
+    (void)page;
+
+    int word = 0;
+    while (aging->nonempty[word] == 0) {
+        word++;
+    }
+    int level = word * 64 + __builtin_ctzll(aging->nonempty[word]);
+    int frame = aging->levels[level].head;
+    aging_erase(aging, frame);
+    return frame;
+}
+
+static void aging_destroy(void* state) {
+    AgingState* aging = (AgingState*)state;
+    free_list_links(&aging->links);
+    free(aging->counter);
+    free(aging->referenced);
+    free(aging->level);
+    free(aging);
+}
+
+ReplacementPolicy* create_aging_policy(int num_frames) {
+    AgingState* aging = (AgingState*)calloc(1, sizeof(AgingState));
+    aging->num_frames = num_frames;
+    aging->until_tick = num_frames;
+    aging->counter = (unsigned char*)calloc(num_frames, 1);
+    aging->referenced = (unsigned char*)calloc(num_frames, 1);
+    aging->level = (int*)malloc(num_frames * sizeof(int));
+    init_list_links(&aging->links, num_frames);
+    for (int level = 0; level <= AGING_LEVELS; level++) {
+        list_init(&aging->levels[level]);
+    }
+    for (int i = 0; i < num_frames; i++) {
+        aging->level[i] = -1;
+    }
+    return new_policy("Aging", aging, aging_on_hit, aging_on_miss, aging_choose_victim,
+                      aging_destroy);
+}
+
+// 2Q (Johnson and Shasha): pages seen once enter a FIFO (A1in) of about a
+// quarter of the frames; the ones evicted from it are remembered, without
+// their frames, in a ghost FIFO (A1out) of half as many entries as frames.
+// A page referenced again while in A1out goes to an LRU list (Am) of hot
+// pages. One-off scans therefore never push hot pages out. Nodes
+// 0..num_frames-1 are the frames, the rest ghosts.
+
+typedef struct {
+    int num_frames;
+    int max_in;
+    int max_out;
+    ListLinks links;
+    NodeList in;              // A1in
+    NodeList hot;             // Am
+    NodeList out;             // A1out
+    unsigned char* is_hot;    // Frame is on Am
+    int* page_of;             // Page of each node
+    PageMap ghosts;           // Ghost node of each page in A1out
+    int* free_ghosts;
+    int num_free;
+    int promote;              // Victim search found the page in A1out: 1, 0, or -1 not looked
+} TwoQState;
+
+// Remove a page from A1out, returning whether it was there
+static bool twoq_take_ghost(TwoQState* twoq, int page) {
+    int node = page_map_get(&twoq->ghosts, page);
+    if (node == -1) {
+        return false;
+    }
+    list_remove(&twoq->links, &twoq->out, node);
+    page_map_remove(&twoq->ghosts, page);
+    twoq->free_ghosts[twoq->num_free++] = node;
+    return true;
+}
+
+static void twoq_add_ghost(TwoQState* twoq, int page) {
+    if (twoq->out.size == twoq->max_out) {
+        int oldest = twoq->out.tail;
+        list_remove(&twoq->links, &twoq->out, oldest);
+        page_map_remove(&twoq->ghosts, twoq->page_of[oldest]);
+        twoq->free_ghosts[twoq->num_free++] = oldest;
+    }
+
+    int node = twoq->free_ghosts[--twoq->num_free];
+    twoq->page_of[node] = page;
+    list_push_front(&twoq->links, &twoq->out, node);
+    page_map_put(&twoq->ghosts, page, node);
+}
+
+static void twoq_on_hit(void* state, int frame) {
+    TwoQState* twoq = (TwoQState*)state;
+
+    // A1in is FIFO, so only hot pages move
+    if (twoq->is_hot[frame] && frame != twoq->hot.head) {
+        list_remove(&twoq->links, &twoq->hot, frame);
+        list_push_front(&twoq->links, &twoq->hot, frame);
+    }
+}
+
+static void twoq_on_miss(void* state, int page, int frame) {
+    TwoQState* twoq = (TwoQState*)state;
+    bool promote = twoq->promote != -1 ? twoq->promote == 1 : twoq_take_ghost(twoq, page);
+
+    twoq->promote = -1;
+    twoq->page_of[frame] = page;
+    twoq->is_hot[frame] = promote;
+    list_push_front(&twoq->links, promote ? &twoq->hot : &twoq->in, frame);
+}
+
+static int twoq_choose_victim(void* state, int page) {
+    TwoQState* twoq = (TwoQState*)state;
+    int frame;
+
+    // Look the page up before evicting, which may add ghosts
+    twoq->promote = twoq_take_ghost(twoq, page);
+
+    if (twoq->in.size > twoq->max_in || twoq->hot.size == 0) {
+        frame = twoq->in.tail;
+        list_remove(&twoq->links, &twoq->in, frame);
+        twoq_add_ghost(twoq, twoq->page_of[frame]);
+    } else {
+        frame = twoq->hot.tail;
+        list_remove(&twoq->links, &twoq->hot, frame);
+    }
+    return frame;
+}
+
+static void twoq_destroy(void* state) {
+    TwoQState* twoq = (TwoQState*)state;
+    free_list_links(&twoq->links);
+    page_map_free(&twoq->ghosts);
+    free(twoq->is_hot);
+    free(twoq->page_of);
+    free(twoq->free_ghosts);
+    free(twoq);
+}
+
+ReplacementPolicy* create_2q_policy(int num_frames) {
+    TwoQState* twoq = (TwoQState*)malloc(sizeof(TwoQState));
+    twoq->num_frames = num_frames;
+    twoq->max_in = num_frames / 4 > 0 ? num_frames / 4 : 1;
+    twoq->max_out = num_frames / 2 > 0 ? num_frames / 2 : 1;
+    init_list_links(&twoq->links, num_frames + twoq->max_out);
+    list_init(&twoq->in);
+    list_init(&twoq->hot);
+    list_init(&twoq->out);
+    twoq->is_hot = (unsigned char*)calloc(num_frames, 1);
+    twoq->page_of = (int*)malloc((num_frames + twoq->max_out) * sizeof(int));
+    page_map_init(&twoq->ghosts, twoq->max_out);
+    twoq->free_ghosts = (int*)malloc(twoq->max_out * sizeof(int));
+    twoq->num_free = 0;
+    twoq->promote = -1;
+
+    for (int node = num_frames + twoq->max_out - 1; node >= num_frames; node--) {
+        twoq->free_ghosts[twoq->num_free++] = node;
+    }
+    return new_policy("2Q", twoq, twoq_on_hit, twoq_on_miss, twoq_choose_victim, twoq_destroy);
+}
+
+// ARC (Megiddo and Modha): resident pages seen once (T1) or more (T2),
+// plus ghosts of the pages recently evicted from each (B1, B2). A hit on
+// a ghost shows which list was too short and moves the target size of T1
+// towards it, so the cache adapts between recency and frequency.
+
+enum {
+    ARC_T1,
+    ARC_T2,
+    ARC_B1,
+    ARC_B2
+};
+
+typedef struct {
+    int num_frames;
+    int target;               // Target size of T1 (p)
+    ListLinks links;          // Nodes for up to 2 * num_frames pages
+    NodeList lists[4];
+    unsigned char* list_of;   // List each node is on
+    int* page_of;             // Page of each node
+    int* frame_of;            // Frame of each node, -1 for ghosts
+    int* node_of;             // Node of each frame
+    PageMap nodes;            // Node of each resident or ghost page
+    int* free_nodes;
+    int num_free;
+} ArcState;
+
+// Move a node to the most recent end of a list
+static void arc_move(ArcState* arc, int node, int list) {
+    list_remove(&arc->links, &arc->lists[arc->list_of[node]], node);
+    list_push_front(&arc->links, &arc->lists[list], node);
+    arc->list_of[node] = list;
+}
+
+// Forget a page completely
+static void arc_drop(ArcState* arc, int node) {
+    list_remove(&arc->links, &arc->lists[arc->list_of[node]], node);
+    page_map_remove(&arc->nodes, arc->page_of[node]);
+    arc->free_nodes[arc->num_free++] = node;
+}
+
+// Evict the least recent page of T1 or T2, keeping it as a ghost, and
+// return its frame
+static int arc_replace(ArcState* arc, bool in_b2) {
+    int t1 = arc->lists[ARC_T1].size;
+    int node;
+
+    if (t1 > 0 && ((in_b2 && t1 == arc->target) || t1 > arc->target ||
+                   arc->lists[ARC_T2].size == 0)) {
+        node = arc->lists[ARC_T1].tail;
+        arc_move(arc, node, ARC_B1);
+    } else {
+        node = arc->lists[ARC_T2].tail;
+        arc_move(arc, node, ARC_B2);
+    }
+
+    int frame = arc->frame_of[node];
+    arc->frame_of[node] = -1;
+    return frame;
+}
+
+static void arc_on_hit(void* state, int frame) {
+    ArcState* arc = (ArcState*)state;
+    arc_move(arc, arc->node_of[frame], ARC_T2);
+}
+
+static void arc_on_miss(void* state, int page, int frame) {
+    ArcState* arc = (ArcState*)state;
+    int node = page_map_get(&arc->nodes, page);
+
+    if (node != -1) {
+        // A ghost comes back as a frequent page
+        arc_move(arc, node, ARC_T2);
+    } else {
+        node = arc->free_nodes[--arc->num_free];
+        arc->page_of[node] = page;
+        arc->list_of[node] = ARC_T1;
+        list_push_front(&arc->links, &arc->lists[ARC_T1], node);
+        page_map_put(&arc->nodes, page, node);
+    }
+    arc->frame_of[node] = frame;
+    arc->node_of[frame] = node;
+}
+
+static int arc_choose_victim(void* state, int page) {
+    ArcState* arc = (ArcState*)state;
+    int node = page_map_get(&arc->nodes, page);
+    int t1 = arc->lists[ARC_T1].size;
+    int t2 = arc->lists[ARC_T2].size;
+    int b1 = arc->lists[ARC_B1].size;
+    int b2 = arc->lists[ARC_B2].size;
+
+    if (node != -1 && arc->list_of[node] == ARC_B1) {
+        int step = b2 / b1 > 1 ? b2 / b1 : 1;
+        arc->target = arc->target + step < arc->num_frames ? arc->target + step : arc->num_frames;
+        return arc_replace(arc, false);
+    }
+    if (node != -1 && arc->list_of[node] == ARC_B2) {
+        int step = b1 / b2 > 1 ? b1 / b2 : 1;
+        arc->target = arc->target - step > 0 ? arc->target - step : 0;
+        return arc_replace(arc, true);
+    }
+
+    // A new page: keep T1 + B1 within num_frames and all lists within
+    // twice that
+    if (t1 + b1 == arc->num_frames) {
+        if (t1 < arc->num_frames) {
+            arc_drop(arc, arc->lists[ARC_B1].tail);
+            return arc_replace(arc, false);
+        }
+        node = arc->lists[ARC_T1].tail;
+        int frame = arc->frame_of[node];
+        arc_drop(arc, node);
+        return frame;
+    }
+    if (t1 + t2 + b1 + b2 == 2 * arc->num_frames) {
+        arc_drop(arc, arc->lists[ARC_B2].tail);
+    }
+    return arc_replace(arc, false);
+}
+
+static void arc_destroy(void* state) {
+    ArcState* arc = (ArcState*)state;
+    free_list_links(&arc->links);
+    page_map_free(&arc->nodes);
+    free(arc->list_of);
+    free(arc->page_of);
+    free(arc->frame_of);
+    free(arc->node_of);
+    free(arc->free_nodes);
+    free(arc);
+}
+
+ReplacementPolicy* create_arc_policy(int num_frames) {
+    ArcState* arc = (ArcState*)malloc(sizeof(ArcState));
+    int num_nodes = 2 * num_frames;
+
+    arc->num_frames = num_frames;
+    arc->target = 0;
+    init_list_links(&arc->links, num_nodes);
+    for (int list = ARC_T1; list <= ARC_B2; list++) {
+        list_init(&arc->lists[list]);
+    }
+    arc->list_of = (unsigned char*)malloc(num_nodes);
+    arc->page_of = (int*)malloc(num_nodes * sizeof(int));
+    arc->frame_of = (int*)malloc(num_nodes * sizeof(int));
+    arc->node_of = (int*)malloc(num_frames * sizeof(int));
+    page_map_init(&arc->nodes, num_nodes);
+    arc->free_nodes = (int*)malloc(num_nodes * sizeof(int));
+    arc->num_free = 0;
+
+    for (int node = num_nodes - 1; node >= 0; node--) {
+        arc->free_nodes[arc->num_free++] = node;
+    }
+    return new_policy("ARC", arc, arc_on_hit, arc_on_miss, arc_choose_victim, arc_destroy);
+}
@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "policy.h"
+
+void page_map_init(PageMap* map, int capacity) {
+    map->capacity = 16;
+    map->shift = 28;
+    while (map->capacity < 2 * capacity) {
+        map->capacity *= 2;
+        map->shift--;
+    }
+    map->count = 0;
+    map->has_empty_key = false;
+    map->keys = (int*)malloc(map->capacity * sizeof(int));
+    map->values = (int*)malloc(map->capacity * sizeof(int));
+    for (int i = 0; i < map->capacity; i++) {
+        map->keys[i] = EMPTY_KEY;
+    }
+}
+
+void page_map_free(PageMap* map) {
+    free(map->keys);
+    free(map->values);
+}
+
+// Fibonacci hashing: the top bits of the product are the well mixed ones
+static int page_map_home(const PageMap* map, int page) {
+    return (int)(((unsigned int)page * 2654435769u) >> map->shift);
+}
+
+// Slot of a page, or of the empty slot where it would go
+static int page_map_find(const PageMap* map, int page) {
+    int index = page_map_home(map, page);
+    while (map->keys[index] != EMPTY_KEY && map->keys[index] != page) {
+        index = (index + 1) & (map->capacity - 1);
+    }
+    return index;
+}
+
+// Value stored for a page, or -1
+int page_map_get(const PageMap* map, int page) {
+    if (page == EMPTY_KEY) {
+        return map->has_empty_key ? map->empty_key_value : -1;
+    }
+    int index = page_map_find(map, page);
+    return map->keys[index] == page ? map->values[index] : -1;
+}
+
+void page_map_put(PageMap* map, int page, int value) {
+    if (page == EMPTY_KEY) {
+        map->has_empty_key = true;
+        map->empty_key_value = value;
+        return;
+    }
+    int index = page_map_find(map, page);
+    if (map->keys[index] == page) {
+        map->values[index] = value;
+        return;
+    }
+
+    // Keep the map at most half full
+    if (2 * (map->count + 1) > map->capacity) {
+        PageMap grown;
+        page_map_init(&grown, map->capacity);
+        grown.has_empty_key = map->has_empty_key;
+        grown.empty_key_value = map->empty_key_value;
+        for (int i = 0; i < map->capacity; i++) {
+            if (map->keys[i] != EMPTY_KEY) {
+                page_map_put(&grown, map->keys[i], map->values[i]);
+            }
+        }
+        page_map_free(map);
+        *map = grown;
+        index = page_map_find(map, page);
+    }
+
+    map->keys[index] = page;
+    map->values[index] = value;
+    map->count++;
+}
+
+// Remove a page, shifting back later entries of its probe run
+void page_map_remove(PageMap* map, int page) {
+    if (page == EMPTY_KEY) {
+        map->has_empty_key = false;
+        return;
+    }
+    int mask = map->capacity - 1;
+    int index = page_map_find(map, page);
+    if (map->keys[index] != page) {
+        return;
+    }
+
+    int next = (index + 1) & mask;
+    while (map->keys[next] != EMPTY_KEY) {
+        int home = page_map_home(map, map->keys[next]);
+        // Move the entry back if the hole lies between its home and it
+        if (((next - home) & mask) >= ((next - index) & mask)) {
+            map->keys[index] = map->keys[next];
+            map->values[index] = map->values[next];
+            index = next;
+        }
+        next = (next + 1) & mask;
+    }
+    map->keys[index] = EMPTY_KEY;
+    map->count--;
+}
+
+void init_list_links(ListLinks* links, int num_nodes) {
+    links->prev = (int*)malloc(num_nodes * sizeof(int));
+    links->next = (int*)malloc(num_nodes * sizeof(int));
+}
+
+void free_list_links(ListLinks* links) {
+    free(links->prev);
+    free(links->next);
+}
+
+void list_init(NodeList* list) {
+    list->head = -1;
+    list->tail = -1;
+    list->size = 0;
+}
+
+void list_push_front(const ListLinks* links, NodeList* list, int node) {
+    links->prev[node] = -1;
+    links->next[node] = list->head;
+    if (list->head == -1) {
+        list->tail = node;
+    } else {
+        links->prev[list->head] = node;
+    }
+    list->head = node;
+    list->size++;
+}
+
+void list_push_back(const ListLinks* links, NodeList* list, int node) {
+    links->next[node] = -1;
+    links->prev[node] = list->tail;
+    if (list->tail == -1) {
+        list->head = node;
+    } else {
+        links->next[list->tail] = node;
+    }
+    list->tail = node;
+    list->size++;
+}
+
+void list_remove(const ListLinks* links, NodeList* list, int node) {
+    if (links->prev[node] == -1) {
+        list->head = links->next[node];
+    } else {
+        links->next[links->prev[node]] = links->next[node];
+    }
+    if (links->next[node] == -1) {
+        list->tail = links->prev[node];
+    } else {
+        links->prev[links->next[node]] = links->prev[node];
+    }
+    list->size--;
+}
+
+// Find the next occurrence of every reference in one backward pass
+void build_next_use(const int pages[], int n, int next_use[]) {
+    PageMap last_seen;
+    page_map_init(&last_seen, 64);
+
+    for (int i = n - 1; i >= 0; i--) {
+        int next = page_map_get(&last_seen, pages[i]);
+        next_use[i] = next == -1 ? NO_NEXT_USE : next;
+        page_map_put(&last_seen, pages[i], i);
+    }
+
+    page_map_free(&last_seen);
+}
+
+// Bit i set if frames[i] == page, for a block of up to 64 frames. Whole
+// vectors are compared, reading into the padding of the aligned array, and
+// lanes past count are masked off. There is no branch on the data, since the
+// frame holding a page is as good as random and an early exit mispredicts.
+static unsigned long long frame_block_hits(const int frames[], int count, int page) {
+    unsigned long long hits = 0;
+#if defined(__AVX512F__)
+    __m512i wanted = _mm512_set1_epi32(page);
+    for (int i = 0; i < count; i += 16) {
+        __mmask16 equal = _mm512_cmpeq_epi32_mask(_mm512_load_si512(frames + i), wanted);
+        hits |= (unsigned long long)equal << i;
+    }
+#elif defined(__AVX2__)
+    __m256i wanted = _mm256_set1_epi32(page);
+    for (int i = 0; i < count; i += 8) {
+        __m256i equal = _mm256_cmpeq_epi32(_mm256_load_si256((const __m256i*)(frames + i)), wanted);
+        hits |= (unsigned long long)(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(equal)) << i;
+    }
+#else
+    for (int i = 0; i < count; i++) {
+        hits |= (unsigned long long)(frames[i] == page) << i;
+    }
+#endif
+    return count < 64 ? hits & ((1ULL << count) - 1) : hits;
+}
+
+// Only the filled frames count, so an empty frame never matches and a page
+// numbered -1 is still found
+int find_frame(const int frames[], int count, int page) {
+    for (int base = 0; base < count; base += 64) {
+        unsigned long long hits = frame_block_hits(frames + base, count - base < 64 ? count - base : 64, page);
+        if (hits != 0) {
+            return base + __builtin_ctzll(hits);
+        }
+    }
+    return -1;
+}
+
+FrameTable* init_frame_table(int num_frames, ReplacementPolicy* policy) {
+    FrameTable* table = (FrameTable*)malloc(sizeof(FrameTable));
+    // aligned_alloc wants a multiple of the alignment
+    size_t bytes = ((size_t)num_frames * sizeof(int) + FRAME_ALIGN - 1) / FRAME_ALIGN * FRAME_ALIGN;
+
+    table->num_frames = num_frames;
+    table->used = 0;
+    table->frames = (int*)aligned_alloc(FRAME_ALIGN, bytes);
+    table->indexed = num_frames > SCAN_MAX_FRAMES;
+    table->policy = policy;
+    table->references = 0;
+    table->faults = 0;
+    page_map_init(&table->resident, table->indexed ? num_frames : 0);
+
+    // Initialize frames, and the padding the vector compares read, with -1
+    // to indicate empty
+    for (size_t i = 0; i < bytes / sizeof(int); i++) {
+        table->frames[i] = -1;
+    }
+    return table;
+}
+
+void free_frame_table(FrameTable* table) {
+    page_map_free(&table->resident);
+    free(table->frames);
+    free(table);
+}
+
+bool access_page(FrameTable* table, int page, int* evicted) {
+    ReplacementPolicy* policy = table->policy;
+    int frame = table->indexed ? page_map_get(&table->resident, page)
+                               : find_frame(table->frames, table->used, page);
+
+    table->references++;
+    *evicted = -1;
+    if (frame != -1) {
+        policy->on_hit(policy->state, frame);
+        return false;
+    }
+
+    // Frames fill in index order, so the next empty one is frames[used]
+    table->faults++;
+    if (table->used < table->num_frames) {
+        frame = table->used++;
+    } else {
+        frame = policy->choose_victim(policy->state, page);
+        *evicted = table->frames[frame];
+        if (table->indexed) {
+            page_map_remove(&table->resident, *evicted);
+        }
+    }
+
+    table->frames[frame] = page;
+    if (table->indexed) {
+        page_map_put(&table->resident, page, frame);
+    }
+    policy->on_miss(policy->state, page, frame);
+    return true;
+}
+
+long simulate(FrameTable* table, TraceReader* trace, EventSink* sink) {
+    int* pages = (int*)malloc(TRACE_CHUNK * sizeof(int));
+    long n = 0;
+
+    int count;
+    while ((count = read_trace(trace, pages, TRACE_CHUNK)) > 0) {
+        for (int i = 0; i < count; i++) {
+            int evicted;
+            bool fault = access_page(table, pages[i], &evicted);
+            record_reference(sink, pages[i], fault, evicted, table->frames, table->num_frames);
+        }
+        n += count;
+    }
+
+    free(pages);
+    return n;
+}
+
+ReplacementPolicy* create_policy(const char* name, int num_frames, const int pages[], int n) {
+    if (strcmp(name, "fifo") == 0) {
+        return create_fifo_policy(num_frames);
+    } else if (strcmp(name, "lru") == 0) {
+        return create_lru_policy(num_frames);
+    } else if (strcmp(name, "opt") == 0) {
+        return create_opt_policy(num_frames, pages, n);
+    } else if (strcmp(name, "clock") == 0) {
+        return create_clock_policy(num_frames);
+    } else if (strcmp(name, "aging") == 0) {
+        return create_aging_policy(num_frames);
+    } else if (strcmp(name, "2q") == 0) {
+        return create_2q_policy(num_frames);
+    } else if (strcmp(name, "arc") == 0) {
+        return create_arc_policy(num_frames);
+    }
+    return NULL;
+}
+
+bool policy_needs_future(const char* name) {
+    return strcmp(name, "opt") == 0;
+}
+
+void free_policy(ReplacementPolicy* policy) {
+    policy->destroy(policy->state);
+    free(policy);
+}
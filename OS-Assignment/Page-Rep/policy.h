@@ -0,0 +1,132 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+
+#include "trace.h"
+#include "event_sink.h"
+
+#define EMPTY_KEY INT_MIN
+#define NO_NEXT_USE INT_MAX   // Page won't be used again
+#define AGING_LEVELS 256      // Values of the 8-bit aging counter
+
+// Largest frame count whose resident pages are found by scanning the frames
+// with SIMD compares; larger tables keep a page-to-frame hash index. The
+// scan pays off up to about four vectors, and never without SIMD. Can be
+// overridden with -DSCAN_MAX_FRAMES=N.
+#ifndef SCAN_MAX_FRAMES
+#if defined(__AVX512F__)
+#define SCAN_MAX_FRAMES 64
+#elif defined(__AVX2__)
+#define SCAN_MAX_FRAMES 32
+#else
+#define SCAN_MAX_FRAMES 0
+#endif
+#endif
+#define FRAME_ALIGN 64        // Bytes; one AVX-512 vector or cache line
+
+// Open-addressed map from page number to an int (a frame, a list node or
+// a trace position). EMPTY_KEY marks an empty slot, so page EMPTY_KEY
+// itself is kept out of the slots.
+typedef struct {
+    int* keys;
+    int* values;
+    int capacity;   // Power of two
+    int shift;      // 32 - log2(capacity)
+    int count;      // Pages in the slots
+    bool has_empty_key;
+    int empty_key_value;
+} PageMap;
+
+// Doubly-linked lists threaded through shared prev/next index arrays, so
+// a policy keeps all its nodes in flat arrays and moves them in O(1)
+typedef struct {
+    int* prev;
+    int* next;
+} ListLinks;
+
+typedef struct {
+    int head;       // Most recent end
+    int tail;
+    int size;
+} NodeList;
+
+// A replacement policy only decides; the frame table owns the frames and
+// finds resident pages. Each reference is either a hit, reported with the
+// frame holding the page, or a miss. A miss with all frames full first asks
+// the policy for a victim frame, then reports the page loaded into it.
+// Empty frames are filled in index order without asking.
+typedef struct {
+    const char* name;
+    void* state;
+    void (*on_hit)(void* state, int frame);
+    void (*on_miss)(void* state, int page, int frame);
+    int (*choose_victim)(void* state, int page);
+    void (*destroy)(void* state);
+} ReplacementPolicy;
+
+// Physical memory of a simulation
+typedef struct {
+    int num_frames;
+    int used;            // Frames filled so far, in index order
+    int* frames;         // Page in each frame, -1 if empty; FRAME_ALIGN aligned
+    bool indexed;        // More than SCAN_MAX_FRAMES frames, so resident is kept
+    PageMap resident;    // Frame of each resident page
+    ReplacementPolicy* policy;
+    long references;
+    long faults;
+} FrameTable;
+
+void page_map_init(PageMap* map, int capacity);
+void page_map_free(PageMap* map);
+int page_map_get(const PageMap* map, int page);
+void page_map_put(PageMap* map, int page, int value);
+void page_map_remove(PageMap* map, int page);
+
+void init_list_links(ListLinks* links, int num_nodes);
+void free_list_links(ListLinks* links);
+void list_init(NodeList* list);
+void list_push_front(const ListLinks* links, NodeList* list, int node);
+void list_push_back(const ListLinks* links, NodeList* list, int node);
+void list_remove(const ListLinks* links, NodeList* list, int node);
+
+// Next use of every reference: next_use[i] is the position where pages[i]
+// is referenced again, or NO_NEXT_USE
+void build_next_use(const int pages[], int n, int next_use[]);
+
+// Frame among the first count holding page, or -1. Uses AVX-512 or AVX2
+// when compiled with them, scalar compares otherwise. frames must be
+// FRAME_ALIGN aligned and padded to a multiple of it, like a FrameTable's.
+int find_frame(const int frames[], int count, int page);
+
+FrameTable* init_frame_table(int num_frames, ReplacementPolicy* policy);
+// Reference a page, returning true if it faulted. *evicted receives the
+// page it replaced, or -1.
+bool access_page(FrameTable* table, int page, int* evicted);
+// Replay a whole trace, reporting every reference to sink. Returns the
+// number of references.
+long simulate(FrameTable* table, TraceReader* trace, EventSink* sink);
+void free_frame_table(FrameTable* table);
+
+// Policies. OPT needs the whole reference string it will be run on.
+ReplacementPolicy* create_fifo_policy(int num_frames);
+ReplacementPolicy* create_lru_policy(int num_frames);
+ReplacementPolicy* create_opt_policy(int num_frames, const int pages[], int n);
+// OPT on a next-use index from build_next_use, which is only read, so any
+// number of policies replaying the same string can share it. The caller
+// frees it after the policies.
+ReplacementPolicy* create_opt_policy_with_index(int num_frames, const int next_use[]);
+ReplacementPolicy* create_clock_policy(int num_frames);
+ReplacementPolicy* create_aging_policy(int num_frames);
+ReplacementPolicy* create_2q_policy(int num_frames);
+ReplacementPolicy* create_arc_policy(int num_frames);
+
+// Policy by name (fifo, lru, opt, clock, aging, 2q or arc); pages is only
+// used by opt. Returns NULL for an unknown name.
+ReplacementPolicy* create_policy(const char* name, int num_frames, const int pages[], int n);
+bool policy_needs_future(const char* name);
+void free_policy(ReplacementPolicy* policy);
+
+#endif
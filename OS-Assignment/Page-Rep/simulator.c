@@ -0,0 +1,86 @@
+// Page replacement simulator for any policy of the policy framework.
+// Build: gcc simulator.c policy.c policies.c trace.c event_sink.c -pthread
+// (add -mavx2 or -mavx512f to search small frame tables with SIMD)
+// Usage: simulator [-p POLICY] [-o OUTPUT] [TRACE [FRAMES]], replaying the
+// built-in reference string with 3 frames when no trace is given.
+// POLICY is fifo, lru, opt, clock, aging, 2q or arc (default lru).
+// OUTPUT is verbose (every reference, the default without a trace),
+// summary (totals only, the default with one), sample:N, csv:FILE or
+// binary:FILE.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#include "trace.h"
+#include "event_sink.h"
+#include "policy.h"
+
+int main(int argc, char* argv[]) {
+    const char* output = take_option(&argc, argv, "-o");
+    const char* name = take_option(&argc, argv, "-p");
+
+    // Test case
+    int test_pages[] = {1, 2, 3, 4, 1, 2, 5, 1, 2, 3, 4, 5};
+    int num_frames = argc > 2 ? atoi(argv[2]) : 3;
+
+    if (name == NULL) {
+        name = "lru";
+    }
+    if (num_frames <= 0) {
+        printf("Error: Number of frames must be positive\n");
+        return 1;
+    }
+
+    EventSink* sink = open_event_sink(output != NULL ? output : argc > 1 ? "summary" : "verbose",
+                                      NULL);
+    if (sink == NULL) {
+        return 1;
+    }
+
+    TraceReader* trace = open_simulation_trace(argc, argv, test_pages,
+                                               sizeof(test_pages)/sizeof(test_pages[0]));
+    if (trace == NULL) {
+        close_event_sink(sink);
+        return 1;
+    }
+    printf("\nNumber of frames: %d", num_frames);
+
+    // A policy that looks ahead needs the whole trace in memory
+    int* pages = NULL;
+    long n = 0;
+    if (policy_needs_future(name)) {
+        if (trace_length(trace) > INT_MAX) {
+            printf("\nError: Trace is too long\n");
+            close_trace(trace);
+            close_event_sink(sink);
+            return 1;
+        }
+        pages = load_trace(trace, &n);
+        rewind_trace(trace);
+    }
+
+    ReplacementPolicy* policy = create_policy(name, num_frames, pages, (int)n);
+    if (policy == NULL) {
+        printf("\nError: Unknown policy %s (fifo, lru, opt, clock, aging, 2q, arc)\n", name);
+        close_trace(trace);
+        close_event_sink(sink);
+        return 1;
+    }
+    FrameTable* table = init_frame_table(num_frames, policy);
+
+    printf("\n%s Page Replacement Simulation:\n", policy->name);
+    printf("--------------------------------\n");
+
+    n = simulate(table, trace, sink);
+
+    printf("\n\nTotal page faults: %ld\n", table->faults);
+    printf("Page fault rate: %.2f%%\n", (float)table->faults/n * 100);
+
+    free_frame_table(table);
+    free_policy(policy);
+    free(pages);
+    close_trace(trace);
+    return close_event_sink(sink) ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+// Policy x frame count sweep. Replays one trace under every combination
+// of the given policies and frame counts in parallel, and prints the
+// faults of each with a flag where adding frames added faults (Belady's
+// anomaly, possible for FIFO, CLOCK, aging, 2Q and ARC).
+// Build: gcc -O2 sweep.c policy.c policies.c trace.c event_sink.c -pthread
+// (add -mavx2 or -mavx512f to search small frame tables with SIMD)
+//
+// Usage:
+//   sweep [-p POLICIES] [-f FIRST-LAST[:STEP]] [-t THREADS] [TRACE]
+//
+// POLICIES is a comma separated list (default fifo,lru,opt,clock,aging,2q,
+// arc), frame counts default to 1-16, and threads to one per CPU. Without
+// a trace the built-in reference string is used.
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "trace.h"
+#include "policy.h"
+
+#define MAX_POLICIES 16
+
+// One simulation of the sweep
+typedef struct {
+    int policy;      // Index into the sweep's policy names
+    int num_frames;
+    long faults;
+} SweepJob;
+
+// Jobs of one worker. The owner takes from the bottom, idle workers steal
+// from the top, so a thief takes the job the owner would have run last.
+typedef struct {
+    pthread_mutex_t lock;
+    int* jobs;
+    int top;
+    int bottom;
+} JobDeque;
+
+typedef struct {
+    const char* policies[MAX_POLICIES];
+    int num_policies;
+    const int* pages;    // Trace shared read-only by every worker
+    int n;
+    int* next_use;       // Next-use index of the trace for OPT, or NULL
+    SweepJob* jobs;
+    int num_jobs;
+    JobDeque* deques;
+    int num_workers;
+} Sweep;
+
+typedef struct {
+    Sweep* sweep;
+    int id;
+    int stolen;          // Jobs taken from other workers
+} SweepWorker;
+
+long long nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Next job of a worker's own deque, or -1
+int pop_job(JobDeque* deque) {
+    int job = -1;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        job = deque->jobs[--deque->bottom];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return job;
+}
+
+// Oldest job of another worker's deque, or -1
+int steal_job(JobDeque* deque) {
+    int job = -1;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        job = deque->jobs[deque->top++];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return job;
+}
+
+// OPT, the one policy that looks ahead, shares the sweep's next-use index
+// rather than building its own
+void run_job(const Sweep* sweep, SweepJob* job) {
+    const char* name = sweep->policies[job->policy];
+    ReplacementPolicy* policy = policy_needs_future(name)
+                                    ? create_opt_policy_with_index(job->num_frames, sweep->next_use)
+                                    : create_policy(name, job->num_frames, NULL, 0);
+    FrameTable* table = init_frame_table(job->num_frames, policy);
+
+    for (int i = 0; i < sweep->n; i++) {
+        int evicted;
+        access_page(table, sweep->pages[i], &evicted);
+    }
+
+    job->faults = table->faults;
+    free_frame_table(table);
+    free_policy(policy);
+}
+
+// Run jobs until no deque has any left. Jobs never create jobs, so one
+// pass over the other deques that finds nothing means the sweep is done.
+void* sweep_worker(void* arg) {
+    SweepWorker* worker = (SweepWorker*)arg;
+    Sweep* sweep = worker->sweep;
+
+    for (;;) {
+        int job = pop_job(&sweep->deques[worker->id]);
+        for (int k = 1; job == -1 && k < sweep->num_workers; k++) {
+            job = steal_job(&sweep->deques[(worker->id + k) % sweep->num_workers]);
+            worker->stolen += job != -1;
+        }
+        if (job == -1) {
+            return NULL;
+        }
+        run_job(sweep, &sweep->jobs[job]);
+    }
+}
+
+// Deal the jobs out round robin, so each deque gets a mix of cheap and
+// expensive ones, then run them on num_workers threads (this one included)
+int run_sweep(Sweep* sweep) {
+    int num_workers = sweep->num_workers;
+    SweepWorker* workers = (SweepWorker*)calloc(num_workers, sizeof(SweepWorker));
+    pthread_t* threads = (pthread_t*)malloc(num_workers * sizeof(pthread_t));
+    int stolen = 0;
+
+    sweep->deques = (JobDeque*)malloc(num_workers * sizeof(JobDeque));
+    for (int w = 0; w < num_workers; w++) {
+        JobDeque* deque = &sweep->deques[w];
+        pthread_mutex_init(&deque->lock, NULL);
+        deque->jobs = (int*)malloc((sweep->num_jobs / num_workers + 1) * sizeof(int));
+        deque->top = 0;
+        deque->bottom = 0;
+        workers[w].sweep = sweep;
+        workers[w].id = w;
+    }
+    for (int j = 0; j < sweep->num_jobs; j++) {
+        JobDeque* deque = &sweep->deques[j % num_workers];
+        deque->jobs[deque->bottom++] = j;
+    }
+
+    for (int w = 1; w < num_workers; w++) {
+        pthread_create(&threads[w], NULL, sweep_worker, &workers[w]);
+    }
+    sweep_worker(&workers[0]);
+    for (int w = 1; w < num_workers; w++) {
+        pthread_join(threads[w], NULL);
+    }
+
+    for (int w = 0; w < num_workers; w++) {
+        stolen += workers[w].stolen;
+        pthread_mutex_destroy(&sweep->deques[w].lock);
+        free(sweep->deques[w].jobs);
+    }
+    free(sweep->deques);
+    free(threads);
+    free(workers);
+    return stolen;
+}
+
+// Results grouped by policy in increasing frame count, with anomalies
+// against the next smaller frame count of the sweep
+void print_results(const Sweep* sweep) {
+    printf("\n%-8s %8s %12s %11s  %s\n", "Policy", "Frames", "Faults", "Fault rate", "Anomaly");
+    for (int p = 0; p < sweep->num_policies; p++) {
+        long previous = -1;
+        for (int j = 0; j < sweep->num_jobs; j++) {
+            const SweepJob* job = &sweep->jobs[j];
+            if (job->policy != p) {
+                continue;
+            }
+            bool anomaly = previous >= 0 && job->faults > previous;
+            printf("%-8s %8d %12ld %10.2f%%  %s\n", sweep->policies[p], job->num_frames,
+                   job->faults, (float)job->faults/sweep->n * 100, anomaly ? "yes" : "");
+            previous = job->faults;
+        }
+    }
+}
+
+void printUsage(const char* program) {
+    printf("Usage: %s [-p POLICIES] [-f FIRST-LAST[:STEP]] [-t THREADS] [TRACE]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    // Test case: the classic string that shows Belady's anomaly for FIFO
+    int test_pages[] = {1, 2, 3, 4, 1, 2, 5, 1, 2, 3, 4, 5};
+    char policy_list[256] = "fifo,lru,opt,clock,aging,2q,arc";
+    int first = 1, last = 16, step = 1;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_threads = online > 1 ? (int)online : 1;
+    const char* path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            path = argv[i];
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        const char* value = argv[++i];
+        switch (argv[i - 1][1]) {
+            case 'p':
+                snprintf(policy_list, sizeof(policy_list), "%s", value);
+                break;
+            case 'f':
+                if (sscanf(value, "%d-%d:%d", &first, &last, &step) < 2) {
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 't': num_threads = atoi(value); break;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+    if (first <= 0 || last < first || step <= 0 || num_threads <= 0) {
+        printf("Error: Invalid frame range or thread count\n");
+        return 1;
+    }
+
+    Sweep sweep;
+    memset(&sweep, 0, sizeof(sweep));
+    for (char* name = strtok(policy_list, ","); name != NULL; name = strtok(NULL, ",")) {
+        if (sweep.num_policies == MAX_POLICIES) {
+            printf("Error: At most %d policies\n", MAX_POLICIES);
+            return 1;
+        }
+        ReplacementPolicy* policy = create_policy(name, 1, test_pages, 0);
+        if (policy == NULL) {
+            printf("Error: Unknown policy %s (fifo, lru, opt, clock, aging, 2q, arc)\n", name);
+            return 1;
+        }
+        free_policy(policy);
+        sweep.policies[sweep.num_policies++] = name;
+    }
+    if (sweep.num_policies == 0) {
+        printf("Error: No policies to sweep\n");
+        return 1;
+    }
+
+    // Load the trace once; every job replays the same copy
+    TraceReader* trace = path != NULL ? open_trace(path)
+                                      : open_trace_array(test_pages, sizeof(test_pages)/sizeof(test_pages[0]));
+    if (trace == NULL) {
+        return 1;
+    }
+    if (trace_length(trace) > INT_MAX) {
+        printf("Error: Trace is too long\n");
+        close_trace(trace);
+        return 1;
+    }
+    if (trace_length(trace) == 0) {
+        printf("Error: Trace holds no references\n");
+        close_trace(trace);
+        return 1;
+    }
+    long n;
+    int* pages = load_trace(trace, &n);
+    close_trace(trace);
+    sweep.pages = pages;
+    sweep.n = (int)n;
+    for (int p = 0; p < sweep.num_policies; p++) {
+        if (policy_needs_future(sweep.policies[p]) && sweep.next_use == NULL) {
+            sweep.next_use = (int*)malloc((n + 1) * sizeof(int));
+            build_next_use(pages, sweep.n, sweep.next_use);
+        }
+    }
+
+    int num_sizes = (last - first) / step + 1;
+    sweep.num_jobs = sweep.num_policies * num_sizes;
+    sweep.jobs = (SweepJob*)malloc(sweep.num_jobs * sizeof(SweepJob));
+    for (int p = 0; p < sweep.num_policies; p++) {
+        for (int s = 0; s < num_sizes; s++) {
+            SweepJob* job = &sweep.jobs[p * num_sizes + s];
+            job->policy = p;
+            job->num_frames = first + s * step;
+            job->faults = 0;
+        }
+    }
+    sweep.num_workers = num_threads < sweep.num_jobs ? num_threads : sweep.num_jobs;
+
+    printf("Trace: %s (%d references)\n", path != NULL ? path : "built-in", sweep.n);
+    printf("%d simulations: %d policies x %d frame counts on %d threads\n",
+           sweep.num_jobs, sweep.num_policies, num_sizes, sweep.num_workers);
+
+    long long start = nowNanos();
+    int stolen = run_sweep(&sweep);
+    double seconds = (nowNanos() - start) / 1e9;
+
+    print_results(&sweep);
+    printf("\nFinished in %.3f s, %d jobs stolen\n", seconds, stolen);
+
+    free(sweep.jobs);
+    free(sweep.next_use);
+    free(pages);
+    return 0;
+}
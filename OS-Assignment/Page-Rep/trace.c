@@ -0,0 +1,388 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+
+// Refill the text buffer once fewer bytes than this are left, so a number
+// is never split between two reads
+#define TEXT_REFILL 64
+
+static TraceReader* new_reader(TraceSource source) {
+    TraceReader* trace = (TraceReader*)calloc(1, sizeof(TraceReader));
+    trace->source = source;
+    return trace;
+}
+
+// Keep at least TEXT_REFILL unread bytes in the text buffer while the file
+// has more
+static void fill_text_buffer(TraceReader* trace) {
+    size_t left = trace->buffer_bytes - trace->buffer_pos;
+    if (left >= TEXT_REFILL || feof(trace->file)) {
+        return;
+    }
+
+    memmove(trace->buffer, trace->buffer + trace->buffer_pos, left);
+    left += fread(trace->buffer + left, 1, TRACE_TEXT_BUFFER - left, trace->file);
+    trace->buffer[left] = '\0';
+    trace->buffer_bytes = left;
+    trace->buffer_pos = 0;
+}
+
+// Parse the next number of a text trace. Numbers are decimal or 0x hex,
+// separated by anything else; '#' starts a comment up to the end of the
+// line. Each number is shifted right by page_shift, which turns addresses
+// into page numbers. A page that does not fit in an int sets out_of_range.
+static bool next_text_page(TraceReader* trace, int* page) {
+    for (;;) {
+        fill_text_buffer(trace);
+        if (trace->buffer_pos == trace->buffer_bytes) {
+            return false;
+        }
+
+        char* start = trace->buffer + trace->buffer_pos;
+        if (*start == '#') {
+            while (trace->buffer_pos < trace->buffer_bytes &&
+                   trace->buffer[trace->buffer_pos] != '\n') {
+                trace->buffer_pos++;
+                fill_text_buffer(trace);
+            }
+            continue;
+        }
+        bool negative = *start == '-';
+        const char* digits = start + negative;
+        if (!isdigit((unsigned char)*digits)) {
+            trace->buffer_pos++;
+            continue;
+        }
+
+        // Only an explicit 0x prefix means hex, so zero-padded decimal
+        // columns are not read as octal
+        int base = digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X') ? 16 : 10;
+        char* end;
+        errno = 0;
+        unsigned long long magnitude = strtoull(digits, &end, base);
+        trace->buffer_pos += (size_t)(end - start);
+
+        unsigned long long limit = negative ? 1ULL << 63 : (unsigned long long)LLONG_MAX;
+        bool fits = errno != ERANGE && magnitude <= limit;
+        long long value = negative ? (long long)(0 - magnitude) : (long long)magnitude;
+        long long shifted = value >> trace->page_shift;
+        if (!fits || shifted < INT_MIN || shifted > INT_MAX) {
+            trace->out_of_range = true;
+        }
+        *page = (int)shifted;
+        return true;
+    }
+}
+
+static void rewind_text(TraceReader* trace) {
+    rewind(trace->file);
+    trace->buffer_bytes = 0;
+    trace->buffer_pos = 0;
+    trace->buffer[0] = '\0';
+}
+
+static TraceReader* open_text_trace(FILE* file, const char* path, int page_shift) {
+    TraceReader* trace = new_reader(TRACE_SOURCE_TEXT);
+    trace->file = file;
+    trace->buffer = (char*)malloc(TRACE_TEXT_BUFFER + 1);
+    trace->page_shift = page_shift;
+    rewind_text(trace);
+
+    // Text carries no count, so take one pass to find it, checking every
+    // page on the way
+    int page;
+    while (next_text_page(trace, &page)) {
+        trace->length++;
+        if (trace->out_of_range) {
+            printf("Error: %s: reference %ld is not a page number that fits in an int\n", path,
+                   trace->length);
+            close_trace(trace);
+            return NULL;
+        }
+    }
+    rewind_text(trace);
+    return trace;
+}
+
+static TraceReader* open_binary_trace(int fd, const char* path) {
+    TraceHeader header;
+    struct stat info;
+    bool valid = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+                 fstat(fd, &info) == 0 &&
+                 header.version == TRACE_VERSION && header.byte_order == TRACE_BYTE_ORDER &&
+                 (header.encoding == TRACE_FIXED || header.encoding == TRACE_VARINT) &&
+                 header.count >= 0;
+    // Every reference takes at least one byte, four when fixed. Divide
+    // rather than multiply, so a forged count cannot overflow the check.
+    if (valid) {
+        size_t body = (size_t)info.st_size >= sizeof(header) ? (size_t)info.st_size - sizeof(header)
+                                                              : 0;
+        size_t bytes_per_page = header.encoding == TRACE_FIXED ? sizeof(int) : 1;
+        valid = (unsigned long long)header.count <= body / bytes_per_page;
+    }
+    if (!valid) {
+        printf("Error: %s is not a valid trace\n", path);
+        return NULL;
+    }
+
+    TraceReader* trace = new_reader(TRACE_SOURCE_BINARY);
+    trace->encoding = (TraceEncoding)header.encoding;
+    trace->length = header.count;
+    trace->map_bytes = info.st_size;
+    trace->offset = sizeof(header);
+    if (trace->map_bytes > 0) {
+        void* map = mmap(NULL, trace->map_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            printf("Error: Cannot map trace %s\n", path);
+            free(trace);
+            return NULL;
+        }
+        madvise(map, trace->map_bytes, MADV_SEQUENTIAL);
+        trace->map = (const unsigned char*)map;
+    }
+    return trace;
+}
+
+TraceReader* open_trace(const char* path) {
+    return open_trace_with_page_size(path, 1);
+}
+
+TraceReader* open_trace_with_page_size(const char* path, long page_size) {
+    int page_shift = 0;
+    while ((1L << page_shift) < page_size) {
+        page_shift++;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Error: Cannot open trace %s\n", path);
+        return NULL;
+    }
+
+    char magic[8];
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0) {
+        return open_text_trace(file, path, page_shift);
+    }
+
+    TraceReader* trace = open_binary_trace(fileno(file), path);
+    fclose(file);
+    return trace;
+}
+
+TraceReader* open_trace_array(const int pages[], long n) {
+    TraceReader* trace = new_reader(TRACE_SOURCE_ARRAY);
+    trace->array = pages;
+    trace->length = n;
+    return trace;
+}
+
+long trace_length(const TraceReader* trace) {
+    return trace->length;
+}
+
+// Drop mapped pages that have been decoded, a large step at a time
+static void release_consumed(TraceReader* trace) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t end = trace->offset & ~(page_size - 1);
+    if (end - trace->released >= TRACE_RELEASE_BYTES) {
+        madvise((void*)(trace->map + trace->released), end - trace->released, MADV_DONTNEED);
+        trace->released = end;
+    }
+}
+
+static int decode_fixed(TraceReader* trace, int pages[], int count) {
+    memcpy(pages, trace->map + trace->offset, count * sizeof(int));
+    trace->offset += count * sizeof(int);
+    return count;
+}
+
+static int decode_varint(TraceReader* trace, int pages[], int count) {
+    const unsigned char* map = trace->map;
+    size_t offset = trace->offset;
+    int previous = trace->previous;
+    int decoded = 0;
+
+    while (decoded < count) {
+        unsigned int value = 0;
+        int shift = 0;
+        while (offset < trace->map_bytes && (map[offset] & 0x80) && shift < 28) {
+            value |= (unsigned int)(map[offset++] & 0x7f) << shift;
+            shift += 7;
+        }
+        if (offset == trace->map_bytes) {
+            break;   // Truncated trace
+        }
+        value |= (unsigned int)map[offset++] << shift;
+
+        unsigned int delta = (value >> 1) ^ -(value & 1);
+        previous = (int)((unsigned int)previous + delta);
+        pages[decoded++] = previous;
+    }
+
+    trace->offset = offset;
+    trace->previous = previous;
+    return decoded;
+}
+
+int read_trace(TraceReader* trace, int pages[], int max) {
+    long left = trace->length - trace->position;
+    int count = left < max ? (int)left : max;
+    if (count <= 0) {
+        return 0;
+    }
+
+    switch (trace->source) {
+        case TRACE_SOURCE_ARRAY:
+            memcpy(pages, trace->array + trace->position, count * sizeof(int));
+            break;
+        case TRACE_SOURCE_BINARY:
+            count = trace->encoding == TRACE_FIXED ? decode_fixed(trace, pages, count)
+                                                   : decode_varint(trace, pages, count);
+            release_consumed(trace);
+            break;
+        case TRACE_SOURCE_TEXT: {
+            int read = 0;
+            while (read < count && next_text_page(trace, &pages[read])) {
+                read++;
+            }
+            count = read;
+            break;
+        }
+    }
+
+    trace->position += count;
+    return count;
+}
+
+void rewind_trace(TraceReader* trace) {
+    trace->position = 0;
+    if (trace->source == TRACE_SOURCE_BINARY) {
+        trace->offset = sizeof(TraceHeader);
+        trace->released = 0;
+        trace->previous = 0;
+    } else if (trace->source == TRACE_SOURCE_TEXT) {
+        rewind_text(trace);
+    }
+}
+
+int* load_trace(TraceReader* trace, long* n) {
+    long left = trace->length - trace->position;
+    int* pages = (int*)malloc((left > 0 ? left : 1) * sizeof(int));
+    long count = 0;
+
+    for (;;) {
+        int chunk = left - count < TRACE_CHUNK ? (int)(left - count) : TRACE_CHUNK;
+        int read = read_trace(trace, pages + count, chunk);
+        if (read == 0) {
+            break;
+        }
+        count += read;
+    }
+
+    *n = count;
+    return pages;
+}
+
+void close_trace(TraceReader* trace) {
+    if (trace->map != NULL) {
+        munmap((void*)trace->map, trace->map_bytes);
+    }
+    if (trace->file != NULL) {
+        fclose(trace->file);
+    }
+    free(trace->buffer);
+    free(trace);
+}
+
+TraceReader* open_simulation_trace(int argc, char* argv[], const int pages[], long n) {
+    if (argc < 2) {
+        printf("Page Reference String: ");
+        for (long i = 0; i < n; i++) {
+            printf("%d ", pages[i]);
+        }
+        return open_trace_array(pages, n);
+    }
+
+    TraceReader* trace = open_trace(argv[1]);
+    if (trace == NULL) {
+        return NULL;
+    }
+    // There is no fault rate of an empty trace
+    if (trace_length(trace) == 0) {
+        printf("Error: %s holds no references\n", argv[1]);
+        close_trace(trace);
+        return NULL;
+    }
+    printf("Trace: %s (%ld references)", argv[1], trace_length(trace));
+    return trace;
+}
+
+// Write the header; count is filled in again when the writer is closed
+static bool write_header(TraceWriter* writer) {
+    TraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.byte_order = TRACE_BYTE_ORDER;
+    header.encoding = writer->encoding;
+    header.count = writer->count;
+    return fwrite(&header, sizeof(header), 1, writer->file) == 1;
+}
+
+TraceWriter* create_trace(const char* path, TraceEncoding encoding) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Error: Cannot write trace %s\n", path);
+        return NULL;
+    }
+    setvbuf(file, NULL, _IOFBF, TRACE_TEXT_BUFFER);
+
+    TraceWriter* writer = (TraceWriter*)calloc(1, sizeof(TraceWriter));
+    writer->file = file;
+    writer->encoding = encoding;
+    writer->ok = write_header(writer);
+    return writer;
+}
+
+bool write_trace(TraceWriter* writer, const int pages[], int count) {
+    if (writer->encoding == TRACE_FIXED) {
+        writer->ok = writer->ok && fwrite(pages, sizeof(int), count, writer->file) == (size_t)count;
+    } else {
+        unsigned char bytes[5 * 256];
+        for (int i = 0; i < count; i += 256) {
+            int end = count - i < 256 ? count : i + 256;
+            size_t length = 0;
+            for (int j = i; j < end; j++) {
+                unsigned int delta = (unsigned int)pages[j] - (unsigned int)writer->previous;
+                unsigned int value = (delta << 1) ^ -(delta >> 31);
+                while (value >= 0x80) {
+                    bytes[length++] = (unsigned char)(value | 0x80);
+                    value >>= 7;
+                }
+                bytes[length++] = (unsigned char)value;
+                writer->previous = pages[j];
+            }
+            writer->ok = writer->ok && fwrite(bytes, 1, length, writer->file) == length;
+        }
+    }
+    writer->count += count;
+    return writer->ok;
+}
+
+bool close_trace_writer(TraceWriter* writer) {
+    bool ok = writer->ok && fseek(writer->file, 0, SEEK_SET) == 0 && write_header(writer);
+    ok = fclose(writer->file) == 0 && ok;
+    free(writer);
+    return ok;
+}
@@ -0,0 +1,101 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Binary trace file: a TraceHeader followed by count page numbers, either
+// as 4-byte ints or as varints of the difference to the previous page
+// (zigzag encoded, so small steps both ways take one or two bytes)
+#define TRACE_MAGIC "PAGETRCE"
+#define TRACE_VERSION 1
+#define TRACE_BYTE_ORDER 0x01020304u
+#define TRACE_CHUNK 65536            // Pages decoded per read_trace call
+#define TRACE_TEXT_BUFFER (1 << 20)  // Bytes read at once from text traces
+#define TRACE_RELEASE_BYTES (64 << 20)  // Mapped bytes dropped at a time
+
+typedef enum {
+    TRACE_FIXED,    // 4-byte page numbers
+    TRACE_VARINT    // Zigzag varint deltas
+} TraceEncoding;
+
+// Header at the start of a binary trace
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int byte_order;     // TRACE_BYTE_ORDER as the writer stored it
+    unsigned int encoding;
+    unsigned int reserved;
+    long long count;
+} TraceHeader;
+
+typedef enum {
+    TRACE_SOURCE_ARRAY,    // Pages already in memory
+    TRACE_SOURCE_BINARY,   // Mapped binary trace
+    TRACE_SOURCE_TEXT      // Whitespace or comma separated page numbers
+} TraceSource;
+
+// Sequential reader over a trace. Binary traces are mapped read-only and
+// decoded in place; the part already read is dropped from memory as the
+// reader moves on, so traces larger than RAM stream through. Text traces
+// are parsed from a buffer refilled with fread.
+typedef struct {
+    TraceSource source;
+    TraceEncoding encoding;
+    long length;             // References in the whole trace
+    long position;           // References read so far
+
+    const int* array;
+
+    const unsigned char* map;
+    size_t map_bytes;
+    size_t offset;           // Next byte to decode
+    size_t released;         // Bytes before this are no longer needed
+    int previous;            // Last page decoded, for delta encoding
+
+    FILE* file;
+    char* buffer;
+    size_t buffer_bytes;
+    size_t buffer_pos;
+    int page_shift;          // Text holds addresses of 2^page_shift byte pages
+    bool out_of_range;       // A text page did not fit in an int
+} TraceReader;
+
+// Writer of binary traces, used by the converter
+typedef struct {
+    FILE* file;
+    TraceEncoding encoding;
+    long count;
+    int previous;
+    bool ok;
+} TraceWriter;
+
+// Open a trace file, binary or text (detected from the header). Fails if
+// a text trace holds a number that is not an int.
+TraceReader* open_trace(const char* path);
+// Same, reading the numbers of a text trace as byte addresses in pages of
+// page_size bytes (a power of two). Fails if a page number is not an int.
+TraceReader* open_trace_with_page_size(const char* path, long page_size);
+// Read the pages of an array as a trace; the array must outlive the reader
+TraceReader* open_trace_array(const int pages[], long n);
+long trace_length(const TraceReader* trace);
+// Decode up to max following pages into pages[], returning how many were
+// read (0 at the end of the trace)
+int read_trace(TraceReader* trace, int pages[], int max);
+void rewind_trace(TraceReader* trace);
+// Read the rest of a trace into one allocated array of *n pages
+int* load_trace(TraceReader* trace, long* n);
+void close_trace(TraceReader* trace);
+
+// Trace for a simulator run: the file named by argv[1] if there is one,
+// otherwise the built-in reference string. Prints what is being replayed.
+// Fails if the file holds no references.
+TraceReader* open_simulation_trace(int argc, char* argv[], const int pages[], long n);
+
+TraceWriter* create_trace(const char* path, TraceEncoding encoding);
+bool write_trace(TraceWriter* writer, const int pages[], int count);
+// Finish the header and close the file; false if any write failed
+bool close_trace_writer(TraceWriter* writer);
+
+#endif
@@ -0,0 +1,73 @@
+// Convert a page reference trace to the binary trace format read by the
+// simulators. The input may be text (page numbers, or addresses with -p)
+// or another binary trace, which is re-encoded.
+// Build: gcc -O2 trace_convert.c trace.c
+//
+// Usage:
+//   trace_convert [-f] [-p page_size] INPUT OUTPUT
+//
+// -f stores 4-byte page numbers instead of varint deltas. -p reads the
+// numbers of a text trace as byte addresses in pages of page_size bytes.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "trace.h"
+
+void printUsage(const char* program) {
+    printf("Usage: %s [-f] [-p page_size] INPUT OUTPUT\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    TraceEncoding encoding = TRACE_VARINT;
+    long page_size = 0;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-f") == 0) {
+            encoding = TRACE_FIXED;
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            page_size = atol(argv[++i]);
+            if (page_size <= 0 || (page_size & (page_size - 1)) != 0) {
+                printf("Error: Page size must be a power of two\n");
+                return 1;
+            }
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - i != 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    TraceReader* input = open_trace_with_page_size(argv[i], page_size > 0 ? page_size : 1);
+    if (input == NULL) {
+        return 1;
+    }
+
+    TraceWriter* output = create_trace(argv[i + 1], encoding);
+    if (output == NULL) {
+        close_trace(input);
+        return 1;
+    }
+
+    int* pages = (int*)malloc(TRACE_CHUNK * sizeof(int));
+    int count;
+    while ((count = read_trace(input, pages, TRACE_CHUNK)) > 0) {
+        write_trace(output, pages, count);
+    }
+    long written = output->count;
+    bool ok = close_trace_writer(output);
+    free(pages);
+    close_trace(input);
+
+    if (!ok) {
+        printf("Error: Cannot write trace %s\n", argv[i + 1]);
+        return 1;
+    }
+    printf("Wrote %ld references to %s\n", written, argv[i + 1]);
+    return 0;
+}